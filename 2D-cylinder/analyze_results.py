@@ -8,10 +8,29 @@ import matplotlib.pyplot as plt
 import os
 from scipy import signal
 
+def load_binary_series(filename):
+    """Load a binary time series written by navier_simple -ff 1
+
+    Layout: magic "NSTSBIN1", uint32 ncols, ncols x (uint32 len, name),
+    then float64 records of ncols values each.
+    """
+    with open(filename, 'rb') as f:
+        if f.read(8) != b'NSTSBIN1':
+            raise ValueError(f"{filename}: not a binary time series")
+        ncols = int(np.frombuffer(f.read(4), dtype=np.uint32)[0])
+        for _ in range(ncols):
+            length = int(np.frombuffer(f.read(4), dtype=np.uint32)[0])
+            f.read(length)
+        data = np.fromfile(f, dtype=np.float64)
+    return data.reshape(-1, ncols)
+
 def load_forces(filename):
-    """Load force data from file"""
+    """Load force data from file (TSV .dat or binary .bin)"""
     try:
-        data = np.loadtxt(filename)
+        if filename.endswith('.bin'):
+            data = load_binary_series(filename)
+        else:
+            data = np.loadtxt(filename, skiprows=1)  # skip "time Drag Lift" header
         if data.ndim == 1:
             data = data.reshape(1, -1)
         return data[:, 0], data[:, 1], data[:, 2]  # time, Cd, Cl
@@ -90,7 +109,8 @@ def main():
     print("=" * 60)
 
     # Check for available force files
-    force_files = [f for f in os.listdir('.') if f.startswith('forces_') and f.endswith('.dat')]
+    force_files = [f for f in os.listdir('.')
+                   if f.startswith('forces_') and f.endswith(('.dat', '.bin'))]
 
     if not force_files:
         print("No force files found. Run simulation first.")
@@ -124,11 +144,12 @@ def main():
             print(f"  Strouhal number: {stats['St']:.4f}")
 
             # Create plot
-            suffix = f" ({filename.replace('forces_', '').replace('.dat', '')})"
+            stem = os.path.splitext(filename)[0]
+            suffix = f" ({stem.replace('forces_', '')})"
             fig = plot_forces(time, Cd, Cl, suffix)
 
             # Save plot
-            plot_name = filename.replace('.dat', '.png')
+            plot_name = stem + '.png'
             fig.savefig(plot_name, dpi=150, bbox_inches='tight')
             print(f"  Saved plot: {plot_name}")
             plt.close()
@@ -141,7 +162,7 @@ def main():
         print(f"{'File':<20} {'Cd_mean':<10} {'Cl_amp':<10} {'St':<10}")
         print(f"{'-'*50}")
         for fname, stats in results.items():
-            name = fname.replace('forces_', '').replace('.dat', '')
+            name = os.path.splitext(fname)[0].replace('forces_', '')
             print(f"{name:<20} {stats['Cd_mean']:<10.6f} {stats['Cl_amp']:<10.6f} {stats['St']:<10.4f}")
 
     # Physical validation
@@ -151,8 +172,8 @@ def main():
     print("Expected values from literature:")
     print("  Cd_mean: ~1.2-1.4 (after fully developed)")
     print("  St: ~0.16-0.18")
-    print("\nNote: Current implementation is simplified.")
-    print("Full nonlinear convection term needed for accurate results.")
+    print("\nNote: Convection is treated explicitly (first order in time);")
+    print("run with -conv 0 to reproduce the earlier Stokes-only results.")
 
     print(f"\n{'='*60}")
     print("Analysis Complete!")
@@ -0,0 +1,46 @@
+#!/bin/bash
+
+# ============================================================================
+# Velocity-Correction Gradient Benchmark
+# Compares the per-step cost of the three -grad modes of navier_simple
+# (G assembled once, D->MultTranspose, legacy D->Transpose() every step)
+# on meshes of increasing size.
+#
+# Usage: bash bench_gradient.sh [steps] [mesh sizes...]
+#   e.g. bash bench_gradient.sh 20 50 100 200
+# ============================================================================
+
+set -e
+
+STEPS=${1:-20}
+shift || true
+SIZES=${@:-50 100 200}
+DT=0.01
+T_FINAL=$(python3 -c "print($STEPS * $DT)")
+
+if [ ! -f "build/navier_simple" ]; then
+    echo "Error: Executable not found. Run setup_environment.sh first."
+    exit 1
+fi
+
+mkdir -p bench_gradient
+printf "%-10s %-10s %-10s %-10s\n" "mesh" "G-cached" "MultT" "legacy"
+
+for n in $SIZES; do
+    mesh="bench_gradient/cylinder_${n}.mesh"
+    if [ ! -f "$mesh" ]; then
+        python3 generate_cylinder_mesh.py "$n" "$n" > /dev/null
+        mv cylinder_structured.mesh "$mesh"
+    fi
+
+    row=()
+    for mode in 0 1 2; do
+        ms=$(./build/navier_simple -m "$mesh" -dt $DT -t "$T_FINAL" -vs 1000000 \
+                 -grad $mode | awk '$1 == "correction" {print $6}')
+        row+=("$ms")
+    done
+    printf "%-10s %-10s %-10s %-10s\n" "${n}x${n}" "${row[0]}" "${row[1]}" "${row[2]}"
+done
+
+echo ""
+echo "Times are ms per step spent in the velocity correction."
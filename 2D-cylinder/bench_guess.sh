@@ -0,0 +1,40 @@
+#!/bin/bash
+
+# ============================================================================
+# Krylov Initial-Guess Benchmark
+# Average and maximum CG iterations of the momentum and pressure solves with
+# each -ig initial guess (zero, linear, quadratic, projection), run long
+# enough for the wake to start shedding.
+#
+# Usage: bash bench_guess.sh [mesh] [final time] [extra solver options...]
+#   e.g. bash bench_guess.sh cylinder_structured.mesh 20 -bdf 2
+# ============================================================================
+
+set -e
+
+MESH=${1:-cylinder_structured.mesh}
+T_FINAL=${2:-20}
+shift $(( $# < 2 ? $# : 2 ))
+DT=0.01
+
+if [ ! -f "build/navier_simple" ]; then
+    echo "Error: Executable not found. Run setup_environment.sh first."
+    exit 1
+fi
+
+solve_its() { awk -v p="$1" '$1 == p {printf "%s/%s", $7, $8}'; }
+
+printf "%-14s %-16s %-16s %-10s\n" "guess" "momentum its" "pressure its" "solve s"
+
+names=(zero linear quadratic projection)
+for ig in 0 1 2 3; do
+    out=$(./build/navier_simple -m "$MESH" -dt $DT -t "$T_FINAL" -vs 1000000 -ig $ig "$@")
+    secs=$(echo "$out" | awk '$1 == "momentum_solve" || $1 == "pressure_solve" {s += $4} END {print s}')
+    printf "%-14s %-16s %-16s %-10s\n" "${names[$ig]}" \
+        "$(echo "$out" | solve_its momentum_solve)" \
+        "$(echo "$out" | solve_its pressure_solve)" "$secs"
+done
+
+echo ""
+echo "its: average/maximum CG iterations per step; solve s: average time"
+echo "per rank in both solves."
@@ -0,0 +1,64 @@
+#!/bin/bash
+
+# ============================================================================
+# Hybrid MPI+OpenMP Benchmark
+# Runs the same case with a fixed core count split into ranks x threads
+# (-nt): time-loop throughput, element assembly, solve times and iterations,
+# and peak memory per configuration. Fewer ranks give smaller AMG coarse
+# grids and less halo traffic, more threads more shared-memory work.
+#
+# Usage: bash bench_hybrid.sh [mesh] [steps] [extra solver options...]
+#   CONFIGS="128x1 32x4 8x16" bash bench_hybrid.sh cylinder_structured.mesh 20
+# Binding: MAP is appended to mpirun, "%t" is replaced by the thread count
+#   (default: Open MPI "--map-by slot:PE=%t --bind-to core")
+# ============================================================================
+
+set -e
+
+MESH=${1:-cylinder_structured.mesh}
+STEPS=${2:-20}
+shift $(( $# < 2 ? $# : 2 ))
+CONFIGS=${CONFIGS:-128x1 32x4 8x16}
+MAP=${MAP:---map-by slot:PE=%t --bind-to core}
+DT=0.01
+T_FINAL=$(python3 -c "print($STEPS * $DT)")
+
+if [ ! -f "build/navier_simple" ]; then
+    echo "Error: Executable not found. Run setup_environment.sh first."
+    exit 1
+fi
+
+# Fields of the -json summary: loop s, DOFs/s/core, assembly s (max over
+# ranks), momentum/pressure ms per solve and its, MB/rank
+summary() {
+    python3 - "$1" <<'EOF'
+import json, sys
+r = json.load(open(sys.argv[1]))
+ph = r["phases"]
+get = lambda p, k: ph[p][k] if p in ph else 0.0
+asm = sum(get(p, "max_s") for p in ph if p.startswith("assemble_"))
+ms = lambda p: 1e3 * get(p, "avg_s") / ph[p]["calls"] if p in ph else 0.0
+print(f"{r['time_loop_s']:<10.4g} {r['dofs_per_s_per_core']:<12.4g} {asm:<10.4g} "
+      f"{ms('momentum_solve'):<9.3g} {get('momentum_solve', 'avg_its'):<6.3g} "
+      f"{ms('pressure_solve'):<9.3g} {get('pressure_solve', 'avg_its'):<6.3g} "
+      f"{r['peak_rss_mb_max']:<8.1f}")
+EOF
+}
+
+mkdir -p bench_hybrid
+printf "%-9s %-10s %-12s %-10s %-9s %-6s %-9s %-6s %-8s\n" "ranks" "loop s" \
+    "dofs/s/core" "asm s" "mom ms" "its" "pres ms" "its" "MB/rank"
+
+for cfg in $CONFIGS; do
+    np=${cfg%x*}
+    nt=${cfg#*x}
+    json="bench_hybrid/${cfg}.json"
+    OMP_NUM_THREADS=$nt mpirun -np "$np" ${MAP//%t/$nt} ./build/navier_simple \
+        -m "$MESH" -dt $DT -t "$T_FINAL" -vs 1000000 -nt "$nt" -json "$json" "$@" \
+        > "bench_hybrid/${cfg}.log"
+    printf "%-9s %s\n" "$cfg" "$(summary "$json")"
+done
+
+echo ""
+echo "ranks: ranks x threads; asm s: element assembly of M, K, S, D (max over"
+echo "ranks); ms/its: average per solve; MB/rank: peak RSS, max over ranks."
@@ -0,0 +1,53 @@
+#!/bin/bash
+
+# ============================================================================
+# Partial-Assembly Benchmark
+# Compares assembled matrices against -pa (matrix-free) for increasing FE
+# order: time per application of the momentum operator H, peak memory, and
+# the Krylov iterations of the first steps with each -pa preconditioner.
+#
+# Usage: bash bench_pa.sh [mesh] [orders...]
+#   e.g. bash bench_pa.sh cylinder_structured.mesh 2 4 6
+# ============================================================================
+
+set -e
+
+MESH=${1:-cylinder_structured.mesh}
+shift || true
+ORDERS=${@:-2 3 4 5 6}
+REPS=50
+DT=0.01
+T_FINAL=$(python3 -c "print(3 * $DT)")
+
+if [ ! -f "build/navier_simple" ]; then
+    echo "Error: Executable not found. Run setup_environment.sh first."
+    exit 1
+fi
+
+run() {
+    ./build/navier_simple -m "$MESH" -o "$1" -dt $DT -t "$T_FINAL" -vs 1000000 \
+        -mvb $REPS "${@:2}"
+}
+
+matvec_ms() { sed -n 's/^Mat-vec benchmark.*: \([0-9.e+-]*\) ms.*/\1/p'; }
+peak_mb()   { sed -n 's/^Peak memory: \([0-9.e+-]*\) MB.*/\1/p'; }
+solve_its() { awk '$1 == "momentum_solve" || $1 == "pressure_solve" {printf "%s/", $7}' | sed 's/\/$//'; }
+
+printf "%-6s %-12s %-12s %-10s %-10s %-14s %-14s %-14s\n" "order" "asm ms" "pa ms" \
+    "asm MB" "pa MB" "its jacobi" "its cheby" "its lor-amg"
+
+for o in $ORDERS; do
+    asm=$(run "$o")
+    pa_lor=$(run "$o" -pa -pap 2)
+    pa_jac=$(run "$o" -pa -pap 0)
+    pa_cheb=$(run "$o" -pa -pap 1)
+    printf "%-6s %-12s %-12s %-10s %-10s %-14s %-14s %-14s\n" "$o" \
+        "$(echo "$asm" | matvec_ms)" "$(echo "$pa_lor" | matvec_ms)" \
+        "$(echo "$asm" | peak_mb)" "$(echo "$pa_lor" | peak_mb)" \
+        "$(echo "$pa_jac" | solve_its)" "$(echo "$pa_cheb" | solve_its)" \
+        "$(echo "$pa_lor" | solve_its)"
+done
+
+echo ""
+echo "ms: one application of H; MB: peak RSS per rank;"
+echo "its: average momentum/pressure CG iterations per step."
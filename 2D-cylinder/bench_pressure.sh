@@ -0,0 +1,64 @@
+#!/bin/bash
+
+# ============================================================================
+# Pressure Solver Crossover Benchmark
+# Compares AMG-CG against a direct solver (-pds) for the pressure Poisson
+# solve on meshes of increasing size and for several rank counts: one-time
+# setup (AMG hierarchy or factorization), time per solve, and the number of
+# steps after which the factorization has paid for itself.
+#
+# Usage: bash bench_pressure.sh [direct solver] [steps]
+#   direct solver: 1 = MUMPS, 2 = SuperLU_DIST, 3 = STRUMPACK (default 1)
+#   SIZES="50 100 200" NPS="1 2 4" bash bench_pressure.sh 1 20
+# ============================================================================
+
+set -e
+
+SOLVER=${1:-1}
+STEPS=${2:-20}
+SIZES=${SIZES:-50 100 200}
+NPS=${NPS:-1 2 4}
+DT=0.01
+T_FINAL=$(python3 -c "print($STEPS * $DT)")
+
+if [ ! -f "build/navier_simple" ]; then
+    echo "Error: Executable not found. Run setup_environment.sh first."
+    exit 1
+fi
+
+# max [s] and ms/call columns of a phase in the timing report
+phase_max() { awk -v p="$1" '$1 == p {print $5}'; }
+phase_ms()  { awk -v p="$1" '$1 == p {print $6}'; }
+
+mkdir -p bench_pressure
+printf "%-10s %-4s %-12s %-12s %-12s %-12s %-10s\n" "mesh" "np" "amg setup" "amg ms" \
+    "factor s" "direct ms" "break-even"
+
+for n in $SIZES; do
+    mesh="bench_pressure/cylinder_${n}.mesh"
+    if [ ! -f "$mesh" ]; then
+        python3 generate_cylinder_mesh.py "$n" "$n" > /dev/null
+        mv cylinder_structured.mesh "$mesh"
+    fi
+
+    for np in $NPS; do
+        run() {
+            mpirun -np "$np" ./build/navier_simple -m "$mesh" -dt $DT -t "$T_FINAL" \
+                -vs 1000000 "$@"
+        }
+        amg=$(run -pds 0)
+        direct=$(run -pds "$SOLVER")
+        setup=$(echo "$amg" | phase_max amg_setup_pres)
+        amg_ms=$(echo "$amg" | phase_ms pressure_solve)
+        factor=$(echo "$direct" | phase_max pressure_factor)
+        direct_ms=$(echo "$direct" | phase_ms pressure_solve)
+        steps=$(python3 -c "d = $amg_ms - $direct_ms; \
+print(max(0, round(1e3 * ($factor - $setup) / d)) if d > 0 else 'never')")
+        printf "%-10s %-4s %-12s %-12s %-12s %-12s %-10s\n" "${n}x${n}" "$np" "$setup" \
+            "$amg_ms" "$factor" "$direct_ms" "$steps"
+    done
+done
+
+echo ""
+echo "amg setup / factor s: one-time cost (max over ranks); ms: per pressure solve;"
+echo "break-even: steps after which the factorization is cheaper overall."
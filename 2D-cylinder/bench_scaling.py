@@ -0,0 +1,120 @@
+#!/usr/bin/env python3
+"""
+Strong- and weak-scaling benchmark for navier_simple.
+
+Runs a fixed number of time steps at 1..N MPI ranks and collects the
+-json summary of every run (problem size, per-phase timers, peak memory)
+into one JSON report with DOFs/s/core and parallel efficiency.
+
+  strong: the same n x n mesh at every rank count
+  weak:   an n*sqrt(np) x n*sqrt(np) mesh, i.e. a fixed element count per rank
+
+Parallel efficiency is the DOFs/s/core of a run relative to the run with
+the fewest ranks of the same series.
+
+Usage: python3 bench_scaling.py [options] [-- extra solver options...]
+  e.g. python3 bench_scaling.py --nps 1 2 4 8 --size 100 -o scaling.json -- -bdf 2
+"""
+
+import argparse
+import json
+import math
+import os
+import subprocess
+import sys
+
+from generate_cylinder_mesh import generate_cylinder_mesh
+
+
+def make_mesh(workdir, n):
+    """Structured n x n cylinder mesh, generated once per size."""
+    mesh = os.path.join(workdir, f"cylinder_{n}.mesh")
+    if not os.path.exists(mesh):
+        with open(os.devnull, "w") as devnull:
+            stdout, sys.stdout = sys.stdout, devnull
+            try:
+                generate_cylinder_mesh(nx=n, ny=n, radius=0.5,
+                                       domain_x=(-5.0, 15.0), domain_y=(-5.0, 5.0),
+                                       cylinder_center=(0.0, 0.0), output_file=mesh)
+            finally:
+                sys.stdout = stdout
+    return mesh
+
+
+def run_case(args, np, mesh, tag, extra):
+    """One fixed-step run; returns the solver's -json summary."""
+    summary = os.path.join(args.workdir, f"{tag}_np{np}.json")
+    cmd = args.mpirun.split() + ["-np", str(np), args.exe, "-m", mesh,
+                                 "-o", str(args.order), "-dt", str(args.dt),
+                                 "-t", repr(args.steps * args.dt), "-vs", "1000000",
+                                 "-json", summary] + extra
+    log = os.path.join(args.workdir, f"{tag}_np{np}.log")
+    with open(log, "w") as out:
+        status = subprocess.call(cmd, stdout=out, stderr=subprocess.STDOUT)
+    if status != 0:
+        sys.exit(f"Error: '{' '.join(cmd)}' failed with status {status}, see {log}")
+    with open(summary) as f:
+        result = json.load(f)
+    result["mesh"] = os.path.basename(mesh)
+    return result
+
+
+def add_efficiency(runs):
+    base = runs[0]["dofs_per_s_per_core"]
+    for r in runs:
+        r["parallel_efficiency"] = r["dofs_per_s_per_core"] / base if base > 0 else 0.0
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n")[1])
+    parser.add_argument("--exe", default="build/navier_simple", help="solver executable")
+    parser.add_argument("--mpirun", default="mpirun", help="MPI launcher")
+    parser.add_argument("--nps", type=int, nargs="+", default=[1, 2, 4],
+                        help="rank counts")
+    parser.add_argument("--size", type=int, default=100,
+                        help="mesh size n of the strong series and of the weak series at 1 rank")
+    parser.add_argument("--steps", type=int, default=20, help="time steps per run")
+    parser.add_argument("--dt", type=float, default=0.01, help="time step")
+    parser.add_argument("--order", type=int, default=2, help="FE order")
+    parser.add_argument("--mode", choices=["strong", "weak", "both"], default="both")
+    parser.add_argument("--workdir", default="bench_scaling",
+                        help="directory for meshes, logs and per-run summaries")
+    parser.add_argument("-o", "--output", default="bench_scaling.json", help="JSON report")
+    parser.add_argument("extra", nargs="*", help="options passed on to navier_simple")
+    args = parser.parse_args()
+
+    if not os.path.isfile(args.exe):
+        sys.exit("Error: Executable not found. Run setup_environment.sh first.")
+    args.exe = os.path.abspath(args.exe)
+    os.makedirs(args.workdir, exist_ok=True)
+    nps = sorted(set(args.nps))
+
+    report = {"config": {"nps": nps, "size": args.size, "steps": args.steps,
+                         "dt": args.dt, "order": args.order, "options": args.extra}}
+
+    print(f"{'series':<8} {'np':<5} {'mesh':<18} {'dofs':<10} {'loop s':<10} "
+          f"{'dofs/s/core':<14} {'eff':<6} {'MB/rank':<8}")
+    for series in ("strong", "weak"):
+        if args.mode not in (series, "both"):
+            continue
+        runs = []
+        for np in nps:
+            n = args.size if series == "strong" else round(args.size * math.sqrt(np))
+            runs.append(run_case(args, np, make_mesh(args.workdir, n), series, args.extra))
+        add_efficiency(runs)
+        for r in runs:
+            print(f"{series:<8} {r['ranks']:<5} {r['mesh']:<18} "
+                  f"{r['velocity_dofs'] + r['pressure_dofs']:<10} {r['time_loop_s']:<10.4g} "
+                  f"{r['dofs_per_s_per_core']:<14.4g} {r['parallel_efficiency']:<6.3f} "
+                  f"{r['peak_rss_mb_max']:<8.1f}")
+        report[series] = runs
+
+    with open(args.output, "w") as f:
+        json.dump(report, f, indent=2)
+    print(f"\nReport saved to: {args.output}")
+    print("eff: DOFs/s/core relative to the fewest ranks of the series;")
+    print("MB/rank: peak RSS, max over ranks.")
+
+
+if __name__ == "__main__":
+    main()
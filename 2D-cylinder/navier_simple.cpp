@@ -6,21 +6,2912 @@
 #include "mfem.hpp"
 #include <iostream>
 #include <fstream>
+#include <sstream>
 #include <iomanip>
 #include <chrono>
 #include <cmath>
+#include <atomic>
+#include <cstdlib>
+#include <cstdint>
+#include <new>
+#include <string>
+#include <vector>
+#include <map>
+#include <algorithm>
+#include <filesystem>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <sys/resource.h>
+#include <fcntl.h>
+#include <unistd.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 using namespace std;
 using namespace mfem;
 
+// ============================================================================
+// Heap Allocation Counter
+// ============================================================================
+
+// Counts calls to the global operator new so the time loop can be checked
+// for allocator churn (-ca). Allocations made inside hypre go through its own
+// malloc wrappers and are not seen here. Counting is off unless -ca is given;
+// the flag is set once, before any helper or OpenMP thread starts.
+static bool count_heap_allocations = false;
+static atomic<long> heap_allocations(0);
+
+void *operator new(size_t size)
+{
+    if (count_heap_allocations) { heap_allocations.fetch_add(1, memory_order_relaxed); }
+    if (void *ptr = malloc(size ? size : 1)) { return ptr; }
+    throw bad_alloc();
+}
+
+void operator delete(void *ptr) noexcept { free(ptr); }
+void operator delete(void *ptr, size_t) noexcept { free(ptr); }
+
+// Peak resident set size of this process in MB (ru_maxrss is in KB on Linux)
+static double PeakRSSMB()
+{
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss / 1024.0;
+}
+
+// Local nonzeros of a ParCSR matrix (diag + offd blocks), 0 for nullptr
+static long LocalNNZ(const HypreParMatrix *A)
+{
+    if (!A) { return 0; }
+    SparseMatrix diag, offd;
+    HYPRE_BigInt *cmap;
+    A->GetDiag(diag);
+    A->GetOffd(offd, cmap);
+    return diag.NumNonZeroElems() + offd.NumNonZeroElems();
+}
+
+// Comma-separated list of numbers, e.g. "40,100,150"; empty for ""
+static vector<double> ParseList(const char *list)
+{
+    vector<double> values;
+    stringstream ss(list);
+    string item;
+    while (getline(ss, item, ','))
+    {
+        if (!item.empty()) { values.push_back(stod(item)); }
+    }
+    return values;
+}
+
+// ============================================================================
+// Per-Phase Instrumentation
+// ============================================================================
+
+// Named wall-clock timers for the solver phases. Every phase accumulates time
+// and call counts; Krylov solve phases also record iteration counts and final
+// residual norms. Phases are registered during setup so that timing inside
+// the time loop never allocates.
+class Profiler
+{
+public:
+    explicit Profiler(MPI_Comm comm) : comm(comm) { }
+
+    int Register(const string &name, bool is_solve = false)
+    {
+        Phase ph;
+        ph.name = name;
+        ph.is_solve = is_solve;
+        phases.push_back(ph);
+        return (int)phases.size() - 1;
+    }
+
+    void Start(int id) { phases[id].started = MPI_Wtime(); }
+
+    void Stop(int id)
+    {
+        Phase &ph = phases[id];
+        ph.time += MPI_Wtime() - ph.started;
+        ph.calls++;
+    }
+
+    // Record the outcome of the Krylov solve timed by phase id
+    void RecordSolve(int id, const IterativeSolver &solver)
+    {
+        RecordSolve(id, solver.GetNumIterations(), solver.GetFinalNorm());
+    }
+
+    void RecordSolve(int id, int iterations, double final_norm)
+    {
+        Phase &ph = phases[id];
+        ph.iterations += iterations;
+        ph.max_iterations = max(ph.max_iterations, iterations);
+        ph.final_norm = final_norm;
+    }
+
+    int Calls(int id) const { return phases[id].calls; }
+    double Time(int id) const { return phases[id].time; }
+
+    // Write one row per time step to a CSV file (root only). The per-step
+    // phase times are the maximum over ranks.
+    void OpenStepCSV(const char *filename)
+    {
+        csv_enabled = true;
+        int n = (int)phases.size();
+        step_start.SetSize(n);
+        step_time.SetSize(n);
+        step_time_max.SetSize(n);
+        step_its.SetSize(n);
+        if (Mpi::Root())
+        {
+            csv.open(filename);
+            csv << "step,time";
+            for (const Phase &ph : phases)
+            {
+                csv << "," << ph.name << "_s";
+                if (ph.is_solve) { csv << "," << ph.name << "_its," << ph.name << "_res"; }
+            }
+            csv << "\n";
+        }
+    }
+
+    void BeginStep()
+    {
+        if (!csv_enabled) { return; }
+        for (int i = 0; i < (int)phases.size(); i++)
+        {
+            step_start(i) = phases[i].time;
+            step_its[i] = phases[i].iterations;
+        }
+    }
+
+    void EndStep(int step, double t)
+    {
+        if (!csv_enabled) { return; }
+        for (int i = 0; i < (int)phases.size(); i++)
+        {
+            step_time(i) = phases[i].time - step_start(i);
+        }
+        MPI_Reduce(step_time.GetData(), step_time_max.GetData(), step_time.Size(),
+                   MPI_DOUBLE, MPI_MAX, 0, comm);
+        if (!Mpi::Root()) { return; }
+        csv << step << "," << t;
+        for (int i = 0; i < (int)phases.size(); i++)
+        {
+            csv << "," << step_time_max(i);
+            if (phases[i].is_solve)
+            {
+                csv << "," << phases[i].iterations - step_its[i] << ","
+                    << phases[i].final_norm;
+            }
+        }
+        csv << "\n";
+    }
+
+    // Print min/avg/max time over ranks for every phase that was used
+    void Report(ostream &os)
+    {
+        int n = (int)phases.size(), nranks;
+        MPI_Comm_size(comm, &nranks);
+        Vector tmin, tmax, tsum;
+        Reduce(tmin, tmax, tsum);
+        if (csv.is_open()) { csv.close(); }
+        if (!Mpi::Root()) { return; }
+
+        os << "\nPhase timings over " << nranks << " rank(s):\n";
+        os << left << setw(22) << "phase" << right << setw(8) << "calls"
+           << setw(11) << "min [s]" << setw(11) << "avg [s]" << setw(11) << "max [s]"
+           << setw(11) << "ms/call" << setw(9) << "avg its" << setw(9) << "max its"
+           << setw(12) << "last res" << "\n";
+        for (int i = 0; i < n; i++)
+        {
+            const Phase &ph = phases[i];
+            if (ph.calls == 0) { continue; }
+            double avg = tsum(i) / nranks;
+            os << left << setw(22) << ph.name << right << setw(8) << ph.calls
+               << fixed << setprecision(4) << setw(11) << tmin(i) << setw(11) << avg
+               << setw(11) << tmax(i) << setprecision(3) << setw(11)
+               << 1e3 * avg / ph.calls;
+            if (ph.is_solve)
+            {
+                os << setprecision(1) << setw(9) << double(ph.iterations) / ph.calls
+                   << setw(9) << ph.max_iterations << scientific << setprecision(3)
+                   << setw(12) << ph.final_norm;
+            }
+            os.unsetf(ios::floatfield);
+            os << "\n";
+        }
+        os << flush;
+    }
+
+    // The same per-phase data as a JSON object keyed by phase name, with
+    // times in seconds. Collective; only root writes.
+    void WriteJSON(ostream &os)
+    {
+        int nranks;
+        MPI_Comm_size(comm, &nranks);
+        Vector tmin, tmax, tsum;
+        Reduce(tmin, tmax, tsum);
+        if (!Mpi::Root()) { return; }
+
+        const char *sep = "";
+        os << "{";
+        for (int i = 0; i < (int)phases.size(); i++)
+        {
+            const Phase &ph = phases[i];
+            if (ph.calls == 0) { continue; }
+            os << sep << "\n    \"" << ph.name << "\": {\"calls\": " << ph.calls
+               << ", \"min_s\": " << tmin(i) << ", \"avg_s\": " << tsum(i) / nranks
+               << ", \"max_s\": " << tmax(i);
+            if (ph.is_solve)
+            {
+                os << ", \"avg_its\": " << double(ph.iterations) / ph.calls
+                   << ", \"max_its\": " << ph.max_iterations;
+            }
+            os << "}";
+            sep = ",";
+        }
+        os << "\n  }";
+    }
+
+private:
+    // Min, max and sum over ranks of the phase times, on root
+    void Reduce(Vector &tmin, Vector &tmax, Vector &tsum)
+    {
+        int n = (int)phases.size();
+        Vector local(n);
+        tmin.SetSize(n);
+        tmax.SetSize(n);
+        tsum.SetSize(n);
+        for (int i = 0; i < n; i++) { local(i) = phases[i].time; }
+        MPI_Reduce(local.GetData(), tmin.GetData(), n, MPI_DOUBLE, MPI_MIN, 0, comm);
+        MPI_Reduce(local.GetData(), tmax.GetData(), n, MPI_DOUBLE, MPI_MAX, 0, comm);
+        MPI_Reduce(local.GetData(), tsum.GetData(), n, MPI_DOUBLE, MPI_SUM, 0, comm);
+    }
+
+    struct Phase
+    {
+        string name;
+        bool is_solve = false;
+        double started = 0.0, time = 0.0;
+        int calls = 0;
+        long iterations = 0;
+        int max_iterations = 0;
+        double final_norm = 0.0;
+    };
+
+    MPI_Comm comm;
+    vector<Phase> phases;
+
+    bool csv_enabled = false;
+    ofstream csv;
+    Vector step_start, step_time, step_time_max;
+    Array<long> step_its;
+};
+
+// Times the enclosing scope as one call of a profiler phase
+class ScopedPhase
+{
+public:
+    ScopedPhase(Profiler &prof, int id) : prof(prof), id(id) { prof.Start(id); }
+    ~ScopedPhase() { prof.Stop(id); }
+
+private:
+    Profiler &prof;
+    int id;
+};
+
+// ============================================================================
+// Eliminated Operator Cache
+// ============================================================================
+
+// Keeps a system matrix with its essential rows/columns eliminated once.
+// The eliminated columns are stored in Ae, so each step only has to apply
+// B -= Ae*X and B(ess) = X(ess) instead of copying and re-eliminating A.
+class EliminatedOperator
+{
+public:
+    EliminatedOperator(const HypreParMatrix &A, const Array<int> &ess_tdofs)
+        : ess_tdofs(ess_tdofs)
+    {
+        A_elim = new HypreParMatrix(A);
+        A_e = A_elim->EliminateRowsCols(ess_tdofs);
+    }
+
+    ~EliminatedOperator()
+    {
+        delete A_e;
+        delete A_elim;
+    }
+
+    HypreParMatrix &Get() { return *A_elim; }
+
+    // Apply the Dirichlet values stored in X to the right-hand side B
+    void EliminateRHS(const Vector &X, Vector &B) const
+    {
+        A_elim->EliminateBC(*A_e, ess_tdofs, X, B);
+    }
+
+private:
+    const Array<int> &ess_tdofs;
+    HypreParMatrix *A_elim;
+    HypreParMatrix *A_e;
+};
+
+// ============================================================================
+// AMG Preconditioner Lifecycle
+// ============================================================================
+
+// Owns a BoomerAMG hierarchy and rebuilds it only when the operator it was
+// built for changes (time step, BDF order, viscosity or mesh). The hierarchy
+// setup and the V-cycles applied by the Krylov solver are timed as separate
+// phases.
+class AMGPreconditioner : public Solver
+{
+public:
+    AMGPreconditioner(Profiler &prof, const string &name)
+        : Solver(0, false), prof(prof),
+          setup_phase(prof.Register("amg_setup_" + name)),
+          vcycle_phase(prof.Register("amg_vcycle_" + name))
+    { }
+
+    ~AMGPreconditioner() { Clear(); }
+
+    // Let the hierarchy lag behind the operator: Update keeps it while alpha
+    // stays within this relative distance of the value it was built for, even
+    // for a new matrix. The hierarchy then holds its own copy of the matrix
+    // it was built from, since the caller may delete the original.
+    void SetRebuildTolerance(double tol) { rebuild_tol = tol; }
+
+    // Build the hierarchy for A unless it was already built for the same
+    // matrix, mass coefficient (b0/dt), nu and mesh sequence. Returns true if
+    // a setup was done.
+    bool Update(const HypreParMatrix &A, double alpha, double nu, long mesh_sequence)
+    {
+        const bool same_alpha = (rebuild_tol > 0.0) ?
+                                fabs(alpha - key_alpha) <= rebuild_tol * fabs(key_alpha) :
+                                (built_for == &A && alpha == key_alpha);
+        if (amg && same_alpha && nu == key_nu && mesh_sequence == key_mesh)
+        {
+            built_for = &A;
+            return false;
+        }
+        key_alpha = alpha;
+        key_nu = nu;
+        key_mesh = mesh_sequence;
+        Build(A);
+        return true;
+    }
+
+    // Drop the hierarchy, e.g. when the matrix it points to is destroyed
+    void Clear()
+    {
+        delete amg;
+        delete A_copy;
+        amg = nullptr;
+        A_copy = nullptr;
+        built_for = nullptr;
+    }
+
+    // Called by the Krylov solver; a no-op if the hierarchy is current
+    void SetOperator(const Operator &op) override
+    {
+        if (amg && built_for == &op) { return; }
+        const HypreParMatrix *A = dynamic_cast<const HypreParMatrix *>(&op);
+        MFEM_VERIFY(A, "AMGPreconditioner requires a HypreParMatrix");
+        Build(*A);
+    }
+
+    void Mult(const Vector &b, Vector &x) const override
+    {
+        ScopedPhase timer(prof, vcycle_phase);
+        amg->Mult(b, x);
+    }
+
+    int NumSetups() const { return prof.Calls(setup_phase); }
+
+private:
+    void Build(const HypreParMatrix &A)
+    {
+        height = width = A.Height();
+        Clear();
+
+        ScopedPhase timer(prof, setup_phase);
+        if (rebuild_tol > 0.0) { A_copy = new HypreParMatrix(A); }
+        amg = new HypreBoomerAMG(A_copy ? *A_copy : A);
+        amg->SetPrintLevel(0);
+        Vector b(height), x(height);
+        b = 0.0;
+        x = 0.0;
+        amg->Setup(b, x);
+        built_for = &A;
+    }
+
+    HypreBoomerAMG *amg = nullptr;
+    HypreParMatrix *A_copy = nullptr;
+    const Operator *built_for = nullptr;
+    double rebuild_tol = 0.0;
+    double key_alpha = 0.0, key_nu = 0.0;
+    long key_mesh = -1;
+
+    Profiler &prof;
+    int setup_phase, vcycle_phase;
+};
+
+// ============================================================================
+// Matrix-Free Preconditioners
+// ============================================================================
+
+// Preconditioner for a partially assembled form, which has no matrix for
+// BoomerAMG to work on: point Jacobi or Chebyshev built from the assembled
+// diagonal, or AMG on the low-order-refined (LOR) discretization, which is
+// spectrally equivalent to the high-order operator but as sparse as a
+// first-order matrix.
+class PAPreconditioner : public Solver
+{
+public:
+    enum Type { JACOBI = 0, CHEBYSHEV = 1, LOR_AMG = 2 };
+
+    PAPreconditioner(int type, ParBilinearForm &form, const Operator &A,
+                     const Array<int> &ess_tdofs, AMGPreconditioner &amg,
+                     double alpha, double nu)
+        : Solver(A.Height(), false)
+    {
+        ParFiniteElementSpace *fes = form.ParFESpace();
+        if (type == JACOBI)
+        {
+            smoother = new OperatorJacobiSmoother(form, ess_tdofs);
+            prec = smoother;
+        }
+        else if (type == CHEBYSHEV)
+        {
+            Vector diag(A.Height());
+            form.AssembleDiagonal(diag);
+            smoother = new OperatorChebyshevSmoother(A, diag, ess_tdofs, 3, fes->GetComm());
+            prec = smoother;
+        }
+        else
+        {
+            MFEM_VERIFY(type == LOR_AMG, "Unknown PA preconditioner " << type);
+            lor = new ParLORDiscretization(form, ess_tdofs);
+            amg.Update(lor->GetAssembledMatrix(), alpha, nu, fes->GetParMesh()->GetSequence());
+            prec = &amg;
+        }
+    }
+
+    ~PAPreconditioner()
+    {
+        delete smoother;
+        delete lor;
+    }
+
+    // Built for a fixed operator; the Krylov solver's call is a no-op
+    void SetOperator(const Operator &op) override { }
+
+    void Mult(const Vector &b, Vector &x) const override { prec->Mult(b, x); }
+
+private:
+    Solver *smoother = nullptr;
+    ParLORDiscretization *lor = nullptr;
+    Solver *prec = nullptr;
+};
+
+// Time reps applications of the momentum operator; prints ms and DOFs/s
+void BenchmarkMatVec(const Operator &A, MPI_Comm comm, HYPRE_BigInt dofs, int reps)
+{
+    Vector x(A.Width()), y(A.Height());
+    x.Randomize(1);
+    A.Mult(x, y);  // warm-up
+
+    MPI_Barrier(comm);
+    double start = MPI_Wtime();
+    for (int r = 0; r < reps; r++) { A.Mult(x, y); }
+    double time = (MPI_Wtime() - start) / reps;
+    MPI_Allreduce(MPI_IN_PLACE, &time, 1, MPI_DOUBLE, MPI_MAX, comm);
+
+    if (Mpi::Root())
+    {
+        cout << "Mat-vec benchmark (H, " << reps << " applications, " << dofs
+             << " DOFs): " << 1e3 * time << " ms, " << dofs / time << " DOFs/s" << endl;
+    }
+}
+
+// ============================================================================
+// Direct Pressure Solver
+// ============================================================================
+
+// Sparse direct solver for a matrix that stays fixed for the whole run, such
+// as the eliminated pressure Laplacian: the factorization is computed once
+// when the solver is built, and every Mult only does the triangular solves.
+// The packages are those MFEM was configured with; asking for one it lacks
+// aborts with a message.
+class DirectSolver : public Solver
+{
+public:
+    enum Type { MUMPS = 1, SUPERLU = 2, STRUMPACK = 3 };
+
+    DirectSolver(int type, const HypreParMatrix &A)
+        : Solver(A.Height(), false)
+    {
+        if (type == MUMPS)
+        {
+#ifdef MFEM_USE_MUMPS
+            MUMPSSolver *mumps = new MUMPSSolver(A.GetComm());
+            mumps->SetPrintLevel(0);
+            mumps->SetMatrixSymType(MUMPSSolver::MatType::SYMMETRIC_POSITIVE_DEFINITE);
+            mumps->SetOperator(A);
+            solver = mumps;
+#else
+            MFEM_ABORT("MFEM was built without MUMPS (MFEM_USE_MUMPS)");
+#endif
+        }
+        else if (type == SUPERLU)
+        {
+#ifdef MFEM_USE_SUPERLU
+            A_rowloc = new SuperLURowLocMatrix(A);
+            SuperLUSolver *superlu = new SuperLUSolver(A.GetComm());
+            superlu->SetPrintStatistics(false);
+            superlu->SetSymmetricPattern(true);
+            superlu->SetColumnPermutation(superlu::PARMETIS);
+            superlu->SetOperator(*A_rowloc);
+            solver = superlu;
+#else
+            MFEM_ABORT("MFEM was built without SuperLU_DIST (MFEM_USE_SUPERLU)");
+#endif
+        }
+        else
+        {
+            MFEM_VERIFY(type == STRUMPACK, "Unknown direct solver " << type);
+#ifdef MFEM_USE_STRUMPACK
+            A_rowloc = new STRUMPACKRowLocMatrix(A);
+            STRUMPACKSolver *strumpack = new STRUMPACKSolver(A.GetComm());
+            strumpack->SetPrintFactorStatistics(false);
+            strumpack->SetPrintSolveStatistics(false);
+            strumpack->SetKrylovSolver(strumpack::KrylovSolver::DIRECT);
+            strumpack->SetReorderingStrategy(strumpack::ReorderingStrategy::METIS);
+            strumpack->SetOperator(*A_rowloc);
+            solver = strumpack;
+#else
+            MFEM_ABORT("MFEM was built without STRUMPACK (MFEM_USE_STRUMPACK)");
+#endif
+        }
+        // SuperLU and STRUMPACK factor lazily in the first solve: do it here
+        Vector b(height), x(height);
+        b = 0.0;
+        solver->Mult(b, x);
+    }
+
+    ~DirectSolver()
+    {
+        delete solver;
+        delete A_rowloc;
+    }
+
+    // Factored for a fixed matrix
+    void SetOperator(const Operator &op) override { }
+
+    void Mult(const Vector &b, Vector &x) const override { solver->Mult(b, x); }
+
+private:
+    Solver *solver = nullptr;
+    Operator *A_rowloc = nullptr;  // SuperLU/STRUMPACK copy of the matrix
+};
+
+// ============================================================================
+// OpenMP Threading
+// ============================================================================
+
+// Hybrid MPI+OpenMP support (-nt). Without OpenMP everything below runs on
+// one thread. Loops are annotated with OMP(...), which expands to the pragma
+// only in OpenMP builds, so builds without it stay free of unknown-pragma
+// warnings.
+#ifdef _OPENMP
+#define OMP(directive) _Pragma(#directive)
+#else
+#define OMP(directive)
+#endif
+
+static int MaxThreads()
+{
+#ifdef _OPENMP
+    return omp_get_max_threads();
+#else
+    return 1;
+#endif
+}
+
+static int ThreadId()
+{
+#ifdef _OPENMP
+    return omp_get_thread_num();
+#else
+    return 0;
+#endif
+}
+
+// y = sum_j c_j x_j in one threaded pass (y may alias none of the x_j)
+static void LinearCombination(int n, const double *c, const Vector *const *x, Vector &y)
+{
+    const int size = y.Size();
+    double *yd = y.GetData();
+    OMP(omp parallel for schedule(static))
+    for (int i = 0; i < size; i++)
+    {
+        double sum = 0.0;
+        for (int j = 0; j < n; j++) { sum += c[j] * x[j]->GetData()[i]; }
+        yd[i] = sum;
+    }
+}
+
+// y = a x + b y, threaded
+static void Axpby(double a, const Vector &x, double b, Vector &y)
+{
+    const int size = y.Size();
+    const double *xd = x.GetData();
+    double *yd = y.GetData();
+    OMP(omp parallel for schedule(static))
+    for (int i = 0; i < size; i++) { yd[i] = a * xd[i] + b * yd[i]; }
+}
+
+// ParBilinearForm whose element matrices are computed by all threads before
+// the (serial) local assembly. BilinearForm::Assemble() uses precomputed
+// element matrices when it has them, so only the scatter into the sparse
+// matrix stays on one thread. The integrators keep scratch space, so each
+// thread builds its own from `make_integ`; the one added to the form is
+// only used by the serial fallback. Requires a single element type.
+class ThreadedBilinearForm : public ParBilinearForm
+{
+public:
+    using IntegratorFactory = function<BilinearFormIntegrator *()>;
+
+    ThreadedBilinearForm(ParFiniteElementSpace *pf, IntegratorFactory make_integ)
+        : ParBilinearForm(pf), make_integ(make_integ)
+    {
+        AddDomainIntegrator(make_integ());
+    }
+
+    void AssembleThreaded()
+    {
+        const int ne = pfes->GetNE();
+        if (MaxThreads() == 1 || ne == 0 || GetAssemblyLevel() != AssemblyLevel::LEGACY)
+        {
+            Assemble();
+            return;
+        }
+        ParMesh *pmesh = pfes->GetParMesh();
+        const int n = pfes->GetFE(0)->GetDof() * pfes->GetVDim();
+        FreeElementMatrices();
+        element_matrices = new DenseTensor(n, n, ne);
+        double *em = element_matrices->Data();
+
+        // IntRules.Get creates missing rules lazily and without a lock, so
+        // element 0 is done first on this thread to create the rule that all
+        // elements of this (single) type share
+        {
+            BilinearFormIntegrator *integ = make_integ();
+            IsoparametricTransformation T;
+            DenseMatrix elmat;
+            pmesh->GetElementTransformation(0, &T);
+            integ->AssembleElementMatrix(*pfes->GetFE(0), T, elmat);
+            copy(elmat.Data(), elmat.Data() + n * n, em);
+            delete integ;
+        }
+
+        bool uniform = true;
+        OMP(omp parallel reduction(&&:uniform))
+        {
+            BilinearFormIntegrator *integ = make_integ();
+            IsoparametricTransformation T;
+            DenseMatrix elmat;
+            OMP(omp for schedule(static))
+            for (int e = 1; e < ne; e++)
+            {
+                pmesh->GetElementTransformation(e, &T);
+                integ->AssembleElementMatrix(*pfes->GetFE(e), T, elmat);
+                if (elmat.Height() != n) { uniform = false; continue; }
+                copy(elmat.Data(), elmat.Data() + n * n, em + (long)e * n * n);
+            }
+            delete integ;
+        }
+        MFEM_VERIFY(uniform, "ThreadedBilinearForm requires a single element type");
+        Assemble();
+        FreeElementMatrices();
+    }
+
+private:
+    IntegratorFactory make_integ;
+};
+
+// ============================================================================
+// Explicit Convection Kernel
+// ============================================================================
+
+// Evaluates the weak convection term N(u)_i = ((u . grad) u, phi_i) on true
+// dofs without re-assembling a nonlinear form. Basis values/derivatives and
+// the per-element geometric factors (J^{-1}, w det J) are tabulated once in
+// structure-of-arrays layout, so the element kernel below runs unit-stride
+// loops over quadrature points that the compiler can vectorize. Elements are
+// processed by all threads into an element vector, which a second threaded
+// pass gathers into the local vector through a precomputed dof-to-element
+// map, so no two threads write to the same entry.
+class ConvectionOperator : public Operator
+{
+public:
+    ConvectionOperator(ParFiniteElementSpace &fes, int order)
+        : Operator(fes.GetTrueVSize()), P(fes.GetProlongationMatrix()),
+          ne(fes.GetNE()), nthreads(MaxThreads()), u_l(fes.GetVSize()),
+          y_l(fes.GetVSize())
+    {
+        ParMesh *pmesh = fes.GetParMesh();
+        MFEM_VERIFY(pmesh->Dimension() == 2 && fes.GetVDim() == 2,
+                    "ConvectionOperator supports 2D vector fields only");
+        if (ne == 0)
+        {
+            nd = nq = 0;
+            l_offsets.SetSize(y_l.Size() + 1);
+            l_offsets = 0;
+            return;
+        }
+
+        const FiniteElement *fe = fes.GetFE(0);
+        const Geometry::Type geom = fe->GetGeomType();
+        const IntegrationRule &ir = IntRules.Get(geom, 3 * order);
+        nd = fe->GetDof();
+        nq = ir.GetNPoints();
+
+        // B(i,q) and G(r,i,q), q fastest
+        B.SetSize(nd * nq);
+        G.SetSize(2 * nd * nq);
+        Vector shape(nd);
+        DenseMatrix dshape(nd, 2);
+        for (int q = 0; q < nq; q++)
+        {
+            fe->CalcShape(ir.IntPoint(q), shape);
+            fe->CalcDShape(ir.IntPoint(q), dshape);
+            for (int i = 0; i < nd; i++)
+            {
+                B(i * nq + q) = shape(i);
+                G((0 * nd + i) * nq + q) = dshape(i, 0);
+                G((1 * nd + i) * nq + q) = dshape(i, 1);
+            }
+        }
+
+        // Element dofs and geometric factors: J^{-1}(0,0), (0,1), (1,0), (1,1), w det J
+        edofs.SetSize(ne * 2 * nd);
+        geo.SetSize(ne * 5 * nq);
+        Array<int> vdofs;
+        for (int e = 0; e < ne; e++)
+        {
+            MFEM_VERIFY(pmesh->GetElementBaseGeometry(e) == geom,
+                        "ConvectionOperator requires a single element type");
+            fes.GetElementVDofs(e, vdofs);
+            for (int k = 0; k < 2 * nd; k++) { edofs[e * 2 * nd + k] = vdofs[k]; }
+
+            ElementTransformation *T = pmesh->GetElementTransformation(e);
+            double *g = geo.GetData() + e * 5 * nq;
+            for (int q = 0; q < nq; q++)
+            {
+                const IntegrationPoint &ip = ir.IntPoint(q);
+                T->SetIntPoint(&ip);
+                const DenseMatrix &Jinv = T->InverseJacobian();
+                g[0 * nq + q] = Jinv(0, 0);
+                g[1 * nq + q] = Jinv(0, 1);
+                g[2 * nq + q] = Jinv(1, 0);
+                g[3 * nq + q] = Jinv(1, 1);
+                g[4 * nq + q] = ip.weight * T->Weight();
+            }
+        }
+
+        // Local dof -> element vector entries (CSR), for the gather
+        const int nl = y_l.Size(), n_e = ne * 2 * nd;
+        l_offsets.SetSize(nl + 1);
+        l_offsets = 0;
+        for (int k = 0; k < n_e; k++) { l_offsets[edofs[k] + 1]++; }
+        l_offsets.PartialSum();
+        l_entries.SetSize(n_e);
+        Array<int> pos(nl);
+        for (int l = 0; l < nl; l++) { pos[l] = l_offsets[l]; }
+        for (int k = 0; k < n_e; k++) { l_entries[pos[edofs[k]]++] = k; }
+
+        y_e.SetSize(n_e);
+        scratch.SetSize(nthreads * ScratchSize());
+    }
+
+    void Mult(const Vector &U, Vector &N) const override
+    {
+        P->Mult(U, u_l);
+        const double *u = u_l.GetData();
+        double *ye = y_e.GetData();
+        OMP(omp parallel for schedule(static))
+        for (int e = 0; e < ne; e++)
+        {
+            ElementKernel(e, u, ye + e * 2 * nd,
+                          scratch.GetData() + ThreadId() * ScratchSize());
+        }
+        const int nl = y_l.Size();
+        double *y = y_l.GetData();
+        OMP(omp parallel for schedule(static))
+        for (int l = 0; l < nl; l++)
+        {
+            double sum = 0.0;
+            for (int k = l_offsets[l]; k < l_offsets[l + 1]; k++) { sum += ye[l_entries[k]]; }
+            y[l] = sum;
+        }
+        P->MultTranspose(y_l, N);
+    }
+
+    // Number of quadrature-point evaluations per application
+    long QuadraturePoints() const { return (long)ne * nq; }
+
+private:
+    // Per-thread scratch: element dofs, point values, gradients and fluxes
+    int ScratchSize() const { return 2 * nd + 8 * nq; }
+
+    void ElementKernel(int e, const double *u, double *ye, double *work) const
+    {
+        const int *dofs = edofs.GetData() + e * 2 * nd;
+        const double *g = geo.GetData() + e * 5 * nq;
+        double *ue_ = work, *uq_ = ue_ + 2 * nd;
+        double *duq_ = uq_ + 2 * nq, *fq_ = duq_ + 4 * nq;
+
+        for (int k = 0; k < 2 * nd; k++) { ue_[k] = u[dofs[k]]; }
+
+        // Values and reference gradients of both components at the points
+        for (int k = 0; k < 2 * nq; k++) { uq_[k] = 0.0; }
+        for (int k = 0; k < 4 * nq; k++) { duq_[k] = 0.0; }
+        for (int c = 0; c < 2; c++)
+        {
+            double *uqc = uq_ + c * nq;
+            double *dq0 = duq_ + (2 * c + 0) * nq;
+            double *dq1 = duq_ + (2 * c + 1) * nq;
+            for (int i = 0; i < nd; i++)
+            {
+                const double uc = ue_[c * nd + i];
+                const double *Bi = B.GetData() + i * nq;
+                const double *G0i = G.GetData() + (0 * nd + i) * nq;
+                const double *G1i = G.GetData() + (1 * nd + i) * nq;
+                for (int q = 0; q < nq; q++)
+                {
+                    uqc[q] += Bi[q] * uc;
+                    dq0[q] += G0i[q] * uc;
+                    dq1[q] += G1i[q] * uc;
+                }
+            }
+        }
+
+        // (u . grad) u, weighted by w det J
+        for (int c = 0; c < 2; c++)
+        {
+            const double *dq0 = duq_ + (2 * c + 0) * nq;
+            const double *dq1 = duq_ + (2 * c + 1) * nq;
+            double *fqc = fq_ + c * nq;
+            for (int q = 0; q < nq; q++)
+            {
+                const double dx = dq0[q] * g[0 * nq + q] + dq1[q] * g[2 * nq + q];
+                const double dy = dq0[q] * g[1 * nq + q] + dq1[q] * g[3 * nq + q];
+                fqc[q] = g[4 * nq + q] * (uq_[q] * dx + uq_[nq + q] * dy);
+            }
+        }
+
+        // Test with the basis functions into the element vector
+        for (int c = 0; c < 2; c++)
+        {
+            const double *fqc = fq_ + c * nq;
+            for (int i = 0; i < nd; i++)
+            {
+                const double *Bi = B.GetData() + i * nq;
+                double sum = 0.0;
+                for (int q = 0; q < nq; q++) { sum += Bi[q] * fqc[q]; }
+                ye[c * nd + i] = sum;
+            }
+        }
+    }
+
+    const Operator *P;
+    int ne, nthreads, nd, nq;
+    Vector B, G, geo;
+    Array<int> edofs, l_offsets, l_entries;
+    mutable Vector u_l, y_l, y_e, scratch;
+};
+
+// Compare the explicit kernel against a ParNonlinearForm with
+// VectorConvectionNLFIntegrator on a smooth field; prints DOFs/s for both
+void BenchmarkConvection(ParFiniteElementSpace &fes, const Operator &kernel,
+                         const Operator &nlform, int reps)
+{
+    ParGridFunction w(&fes);
+    VectorFunctionCoefficient w_coeff(2, [](const Vector &x, Vector &v)
+    {
+        v(0) = 1.0 + 0.1 * sin(x(0)) * cos(x(1));
+        v(1) = 0.1 * cos(x(0));
+    });
+    w.ProjectCoefficient(w_coeff);
+
+    Vector W(fes.GetTrueVSize()), N_kernel(W.Size()), N_nlf(W.Size());
+    w.GetTrueDofs(W);
+
+    double times[2];
+    const Operator *ops[2] = {&kernel, &nlform};
+    Vector *outs[2] = {&N_kernel, &N_nlf};
+    for (int k = 0; k < 2; k++)
+    {
+        ops[k]->Mult(W, *outs[k]);  // warm-up
+        MPI_Barrier(fes.GetComm());
+        double start = MPI_Wtime();
+        for (int r = 0; r < reps; r++) { ops[k]->Mult(W, *outs[k]); }
+        times[k] = (MPI_Wtime() - start) / reps;
+    }
+    MPI_Allreduce(MPI_IN_PLACE, times, 2, MPI_DOUBLE, MPI_MAX, fes.GetComm());
+
+    Vector diff(W.Size());
+    subtract(N_kernel, N_nlf, diff);
+    double rel = sqrt(InnerProduct(fes.GetComm(), diff, diff) /
+                      InnerProduct(fes.GetComm(), N_nlf, N_nlf));
+
+    const double dofs = fes.GlobalTrueVSize();
+    if (Mpi::Root())
+    {
+        cout << "Convection benchmark (" << reps << " applications, "
+             << dofs << " DOFs):" << endl;
+        cout << "  explicit kernel: " << 1e3 * times[0] << " ms, "
+             << dofs / times[0] << " DOFs/s" << endl;
+        cout << "  NonlinearForm:   " << 1e3 * times[1] << " ms, "
+             << dofs / times[1] << " DOFs/s" << endl;
+        cout << "  speedup " << times[1] / times[0] << "x, relative difference "
+             << rel << endl;
+    }
+}
+
+// ============================================================================
+// Cylinder Force Evaluation
+// ============================================================================
+
+// Drag and lift from the traction (-p I + 2 nu eps(u)) n integrated over the
+// faces of the boundary elements with the cylinder attribute. These need not
+// be true boundary faces: generate_cylinder_mesh.py keeps elements inside
+// the attribute-1 segments, so the faces are looked up by index and the
+// traction is taken from the element on the side away from the cylinder
+// centre, with the normal pointing out of that element. Element dofs, basis
+// values and physical basis gradients at the face quadrature points are
+// tabulated once, so Compute() is a few dense loops and one MPI_Allreduce.
+class SurfaceForces
+{
+public:
+    SurfaceForces(ParFiniteElementSpace &fes_vel, ParFiniteElementSpace &fes_pres,
+                  int cyl_attr, int order)
+        : comm(fes_vel.GetComm()), nf(0), nq(0), nd_u(0), nd_p(0)
+    {
+        ParMesh &pmesh = *fes_vel.GetParMesh();
+        const int dim = pmesh.Dimension();
+        MFEM_VERIFY(dim == 2, "SurfaceForces supports 2D meshes only");
+
+        // Cylinder centre: mean of the (physical) face midpoints; vertex
+        // coordinates are not valid on meshes with curved nodes
+        Array<int> bdr;
+        Vector x(dim);
+        double centre[3] = {0.0, 0.0, 0.0};
+        for (int be = 0; be < pmesh.GetNBE(); be++)
+        {
+            if (pmesh.GetBdrAttribute(be) != cyl_attr) { continue; }
+            bdr.Append(be);
+            pmesh.GetBdrElementTransformation(be)->Transform(
+                Geometries.GetCenter(pmesh.GetBdrElementGeometry(be)), x);
+            centre[0] += x(0);
+            centre[1] += x(1);
+            centre[2] += 1.0;
+        }
+        MPI_Allreduce(MPI_IN_PLACE, centre, 3, MPI_DOUBLE, MPI_SUM, comm);
+        if (centre[2] == 0.0) { return; }
+        const double cx = centre[0] / centre[2], cy = centre[1] / centre[2];
+
+        nf = bdr.Size();
+        if (nf == 0) { return; }
+        const IntegrationRule &ir = IntRules.Get(Geometry::SEGMENT, 2 * order);
+        nq = ir.GetNPoints();
+        nd_u = fes_vel.GetFE(0)->GetDof();
+        nd_p = fes_pres.GetFE(0)->GetDof();
+        udofs.SetSize(nf * 2 * nd_u);
+        pdofs.SetSize(nf * nd_p);
+        wnor.SetSize(nf * nq * 2);
+        bp.SetSize(nf * nq * nd_p);
+        gu.SetSize(nf * nq * nd_u * 2);
+
+        Vector nor(dim), c1(dim), c2(dim), shape(nd_p);
+        DenseMatrix dshape(nd_u, dim);
+        Array<int> vdofs;
+        for (int f = 0; f < nf; f++)
+        {
+            const int face = pmesh.GetBdrElementFaceIndex(bdr[f]);
+            FaceElementTransformations *Tr = pmesh.GetFaceElementTransformations(face);
+            MFEM_VERIFY(Tr && Tr->Elem1, "SurfaceForces: face without a local element");
+
+            // Traction side and the sign that turns CalcOrtho's normal (out of
+            // element 1) into the outward normal of the fluid. On a true
+            // boundary face element 1 is the fluid. On an interior face the
+            // fluid is the neighbour farther from the centre; if the other
+            // neighbour is on another rank, element 1 is used from whichever
+            // side it is on.
+            bool side2 = false;
+            double sign = 1.0;
+            if (pmesh.FaceIsTrueInterior(face))
+            {
+                pmesh.GetElementCenter(Tr->Elem1No, c1);
+                const double r1 = hypot(c1(0) - cx, c1(1) - cy);
+                if (Tr->Elem2No >= 0)
+                {
+                    pmesh.GetElementCenter(Tr->Elem2No, c2);
+                    side2 = (hypot(c2(0) - cx, c2(1) - cy) > r1);
+                    sign = side2 ? -1.0 : 1.0;
+                }
+                else
+                {
+                    Tr->Transform(Geometries.GetCenter(Tr->GetGeometryType()), x);
+                    sign = (r1 > hypot(x(0) - cx, x(1) - cy)) ? 1.0 : -1.0;
+                }
+            }
+            const int e = side2 ? Tr->Elem2No : Tr->Elem1No;
+            const FiniteElement *fe_u = fes_vel.GetFE(e), *fe_p = fes_pres.GetFE(e);
+            MFEM_VERIFY(fe_u->GetDof() == nd_u && fe_p->GetDof() == nd_p,
+                        "SurfaceForces requires a single element type");
+
+            fes_vel.GetElementVDofs(e, vdofs);
+            for (int k = 0; k < 2 * nd_u; k++) { udofs[f * 2 * nd_u + k] = vdofs[k]; }
+            fes_pres.GetElementDofs(e, vdofs);
+            for (int k = 0; k < nd_p; k++) { pdofs[f * nd_p + k] = vdofs[k]; }
+
+            for (int q = 0; q < nq; q++)
+            {
+                const IntegrationPoint &ip = ir.IntPoint(q);
+                Tr->SetAllIntPoints(&ip);
+                ElementTransformation &T = side2 ? *Tr->Elem2 : *Tr->Elem1;
+                const IntegrationPoint &eip = side2 ? Tr->GetElement2IntPoint()
+                                              : Tr->GetElement1IntPoint();
+
+                // |nor| is the face measure, so no extra weight is needed
+                CalcOrtho(Tr->Jacobian(), nor);
+                const int k = f * nq + q;
+                wnor(2 * k + 0) = sign * ip.weight * nor(0);
+                wnor(2 * k + 1) = sign * ip.weight * nor(1);
+
+                fe_p->CalcShape(eip, shape);
+                for (int i = 0; i < nd_p; i++) { bp(k * nd_p + i) = shape(i); }
+                fe_u->CalcPhysDShape(T, dshape);
+                for (int i = 0; i < nd_u; i++)
+                {
+                    gu((k * nd_u + i) * 2 + 0) = dshape(i, 0);
+                    gu((k * nd_u + i) * 2 + 1) = dshape(i, 1);
+                }
+            }
+        }
+    }
+
+    // Force exerted by the fluid on the cylinder: F = -int_S sigma n dS,
+    // with n the outward normal of the fluid domain
+    void Compute(const ParGridFunction &u, const ParGridFunction &p, double nu,
+                 double F[2])
+    {
+        double local[2] = {0.0, 0.0};
+
+        for (int f = 0; f < nf; f++)
+        {
+            const int *ud = udofs.GetData() + f * 2 * nd_u;
+            const int *pd = pdofs.GetData() + f * nd_p;
+            for (int q = 0; q < nq; q++)
+            {
+                const int k = f * nq + q;
+                const double *b = bp.GetData() + k * nd_p;
+                const double *g = gu.GetData() + k * nd_u * 2;
+                const double *n = wnor.GetData() + 2 * k;
+
+                double pval = 0.0;
+                for (int i = 0; i < nd_p; i++) { pval += b[i] * p(pd[i]); }
+                // grad(c, j) = d u_c / d x_j
+                double grad[2][2] = {{0.0, 0.0}, {0.0, 0.0}};
+                for (int c = 0; c < 2; c++)
+                {
+                    for (int i = 0; i < nd_u; i++)
+                    {
+                        const double uc = u(ud[c * nd_u + i]);
+                        grad[c][0] += uc * g[2 * i + 0];
+                        grad[c][1] += uc * g[2 * i + 1];
+                    }
+                }
+
+                for (int i = 0; i < 2; i++)
+                {
+                    double traction = -pval * n[i];
+                    for (int j = 0; j < 2; j++)
+                    {
+                        traction += nu * (grad[i][j] + grad[j][i]) * n[j];
+                    }
+                    local[i] -= traction;
+                }
+            }
+        }
+
+        MPI_Allreduce(local, F, 2, MPI_DOUBLE, MPI_SUM, comm);
+    }
+
+private:
+    MPI_Comm comm;
+    int nf, nq, nd_u, nd_p;
+    Array<int> udofs, pdofs;
+    Vector wnor, bp, gu;
+};
+
+// Variationally consistent drag and lift: the momentum residual
+//   R = M (b0 U - U_hist)/dt + nu K U + N* - D^T P
+// (U_hist = sum_j b_j U^{n+1-j}, N* the extrapolated convection)
+// tested with v = e_x (e_y) on the cylinder DOFs and 0 elsewhere equals the
+// boundary integral of sigma n against v, so F_i = -R(v_i). This reuses the
+// assembled M, K and D and costs three mat-vecs and one MPI_Allreduce.
+class VolumeForces
+{
+public:
+    VolumeForces(ParFiniteElementSpace &fes_vel, const Operator &M,
+                 const Operator &K, const Operator &D, int cyl_attr)
+        : M(M), K(K), D(D), comm(fes_vel.GetComm()),
+          diff(fes_vel.GetTrueVSize()), R(fes_vel.GetTrueVSize())
+    {
+        Array<int> cyl_bdr(fes_vel.GetMesh()->bdr_attributes.Max());
+        cyl_bdr = 0;
+        cyl_bdr[cyl_attr - 1] = 1;
+        fes_vel.GetEssentialTrueDofs(cyl_bdr, cyl_dofs[0], 0);
+        fes_vel.GetEssentialTrueDofs(cyl_bdr, cyl_dofs[1], 1);
+    }
+
+    // N is the explicit convection term on true dofs, or nullptr for Stokes
+    void Compute(const Vector &U, const Vector &U_hist, double b0, const Vector &P,
+                 const Vector *N, double dt, double nu, double F[2])
+    {
+        add(b0, U, -1.0, U_hist, diff);
+        M.Mult(diff, R);
+        R *= 1.0 / dt;
+        K.AddMult(U, R, nu);
+        D.AddMultTranspose(P, R, -1.0);
+        if (N) { R += *N; }
+
+        double local[2] = {0.0, 0.0};
+        for (int c = 0; c < 2; c++)
+        {
+            for (int i = 0; i < cyl_dofs[c].Size(); i++) { local[c] -= R(cyl_dofs[c][i]); }
+        }
+        MPI_Allreduce(local, F, 2, MPI_DOUBLE, MPI_SUM, comm);
+    }
+
+private:
+    const Operator &M, &K, &D;
+    MPI_Comm comm;
+    Array<int> cyl_dofs[2];
+    Vector diff, R;
+};
+
+// ============================================================================
+// Time-Series Output
+// ============================================================================
+
+// Root-only writer for per-step scalar records (time, Cd, Cl, ...). Other
+// ranks never open the file. Records are collected in a preallocated buffer
+// of buffer_records rows and written when it fills, so there is no per-step
+// flush. With async the full buffer is swapped with a second one and written
+// by a helper thread while the time loop continues; the loop only waits if
+// that write has not finished by the time the next buffer is full.
+//
+// TSV keeps the tab-separated text format with a header line. BINARY writes
+//   char magic[8] = "NSTSBIN1", uint32 ncols, ncols x (uint32 len, name),
+// followed by the records as native-endian float64 rows of ncols values.
+class TimeSeriesWriter
+{
+public:
+    enum Format { TSV = 0, BINARY = 1 };
+
+    TimeSeriesWriter(MPI_Comm comm, const string &filename, const vector<string> &columns,
+                     int format, int buffer_records, bool async, bool append = false,
+                     double keep_before = HUGE_VAL)
+        : ncols((int)columns.size()), format(format),
+          capacity(max(buffer_records, 1) * (int)columns.size()), async(async)
+    {
+        int rank;
+        MPI_Comm_rank(comm, &rank);
+        root = (rank == 0);
+        if (!root) { return; }
+        // Appending (after a restart) continues an existing file without a new
+        // header, from its last record with time < keep_before
+        if (append && filesystem::exists(filename)) { Truncate(filename, format, keep_before); }
+        const bool header = !(append && filesystem::exists(filename) &&
+                              filesystem::file_size(filename) > 0);
+        ios::openmode mode = (format == BINARY) ? ios::out | ios::binary : ios::out;
+        out.open(filename, append ? mode | ios::app : mode);
+        MFEM_VERIFY(out, "Cannot open " << filename);
+        if (header && format == BINARY)
+        {
+            const char magic[8] = {'N', 'S', 'T', 'S', 'B', 'I', 'N', '1'};
+            const uint32_t n = ncols;
+            out.write(magic, sizeof(magic));
+            out.write((const char *)&n, sizeof(n));
+            for (const string &name : columns)
+            {
+                const uint32_t len = name.size();
+                out.write((const char *)&len, sizeof(len));
+                out.write(name.data(), len);
+            }
+        }
+        else if (header)
+        {
+            for (int c = 0; c < ncols; c++) { out << (c ? "\t" : "") << columns[c]; }
+            out << "\n";
+        }
+        front.reserve(capacity);
+        back.reserve(capacity);
+        if (async) { worker = thread(&TimeSeriesWriter::WorkerLoop, this); }
+    }
+
+    ~TimeSeriesWriter() { Close(); }
+
+    // Append one record of ncols values; a no-op on non-root ranks
+    void Append(const double *row)
+    {
+        if (!root) { return; }
+        front.insert(front.end(), row, row + ncols);
+        if ((int)front.size() >= capacity) { Flush(); }
+    }
+
+    // Hand the buffered records to the file (or the helper thread)
+    void Flush()
+    {
+        if (!root || front.empty()) { return; }
+        if (!async)
+        {
+            Write(front);
+            front.clear();
+            return;
+        }
+        unique_lock<mutex> lock(mtx);
+        cv.wait(lock, [this] { return !pending; });
+        front.swap(back);
+        pending = true;
+        cv.notify_all();
+    }
+
+    // Write everything still buffered, stop the helper thread, close the file
+    void Close()
+    {
+        if (!root || !out.is_open()) { return; }
+        Flush();
+        if (async)
+        {
+            {
+                unique_lock<mutex> lock(mtx);
+                cv.wait(lock, [this] { return !pending; });
+                done = true;
+                cv.notify_all();
+            }
+            worker.join();
+        }
+        out.close();
+    }
+
+private:
+    // Cut an existing file after its last record with time < keep_before. The
+    // records after it were written between the resumed checkpoint and a
+    // crash and are written again; a partial last record is dropped too.
+    static void Truncate(const string &filename, int format, double keep_before)
+    {
+        ifstream in(filename, ios::binary);
+        streamoff keep = 0;
+        if (format == BINARY)
+        {
+            char magic[8];
+            uint32_t n = 0, len = 0;
+            in.read(magic, sizeof(magic));
+            in.read((char *)&n, sizeof(n));
+            for (uint32_t c = 0; in && c < n; c++)
+            {
+                in.read((char *)&len, sizeof(len));
+                in.seekg(len, ios::cur);
+            }
+            if (in && n > 0)
+            {
+                keep = in.tellg();
+                vector<double> row(n);
+                while (in.read((char *)row.data(), n * sizeof(double)) && row[0] < keep_before)
+                {
+                    keep = in.tellg();
+                }
+            }
+        }
+        else
+        {
+            // Header line, then one record per complete line
+            string line;
+            bool header = true;
+            while (getline(in, line) && !in.eof())
+            {
+                if (!header && !(strtod(line.c_str(), nullptr) < keep_before)) { break; }
+                header = false;
+                keep = in.tellg();
+            }
+        }
+        in.close();
+        filesystem::resize_file(filename, keep);
+    }
+
+    void Write(const vector<double> &records)
+    {
+        if (format == BINARY)
+        {
+            out.write((const char *)records.data(), records.size() * sizeof(double));
+        }
+        else
+        {
+            for (size_t i = 0; i < records.size(); i++)
+            {
+                out << records[i] << ((i + 1) % ncols ? "\t" : "\n");
+            }
+        }
+        out.flush();
+    }
+
+    void WorkerLoop()
+    {
+        unique_lock<mutex> lock(mtx);
+        while (true)
+        {
+            cv.wait(lock, [this] { return pending || done; });
+            if (!pending) { return; }
+            lock.unlock();
+            Write(back);
+            back.clear();
+            lock.lock();
+            pending = false;
+            cv.notify_all();
+        }
+    }
+
+    bool root;
+    int ncols, format, capacity;
+    bool async;
+    ofstream out;
+    vector<double> front, back;
+
+    thread worker;
+    mutex mtx;
+    condition_variable cv;
+    bool pending = false, done = false;
+};
+
+// ============================================================================
+// Field Output
+// ============================================================================
+
+// Scalar vorticity w = dv/dx - du/dy of a 2D velocity, interpolated at the
+// nodes of a discontinuous L2 space one order below the velocity. Purely
+// element-local, so it needs no communication.
+class VorticityField
+{
+public:
+    VorticityField(ParMesh &pmesh, int order)
+        : fec(max(order - 1, 0), pmesh.Dimension()), fes(&pmesh, &fec), w(&fes)
+    {
+        w = 0.0;
+    }
+
+    void Update(const ParGridFunction &u)
+    {
+        ParMesh *pmesh = fes.GetParMesh();
+        for (int e = 0; e < fes.GetNE(); e++)
+        {
+            const IntegrationRule &nodes = fes.GetFE(e)->GetNodes();
+            ElementTransformation *T = pmesh->GetElementTransformation(e);
+            fes.GetElementDofs(e, dofs);
+            for (int i = 0; i < nodes.GetNPoints(); i++)
+            {
+                T->SetIntPoint(&nodes.IntPoint(i));
+                u.GetVectorGradient(*T, grad);
+                w(dofs[i]) = grad(1, 0) - grad(0, 1);
+            }
+        }
+    }
+
+    ParGridFunction &Get() { return w; }
+
+private:
+    L2_FECollection fec;
+    ParFiniteElementSpace fes;
+    ParGridFunction w;
+    Array<int> dofs;
+    DenseMatrix grad;
+};
+
+// ============================================================================
+// BDFk/EXTk Time Integration
+// ============================================================================
+
+const int max_bdf_order = 3;
+
+// Coefficients of BDFk/EXTk for variable steps. dts[0] is the step being
+// taken (t^{n+1} - t^n) and dts[j] the j-th previous one. Then
+//   du/dt(t^{n+1}) ~ (b[0] u^{n+1} - sum_j b[j] u^{n+1-j}) / dts[0]
+//   f(t^{n+1})     ~ sum_j e[j] f^{n+1-j},    j = 1..k
+// from Lagrange interpolation through the k+1 (resp. k) latest states. For
+// constant steps this gives the textbook BDF2 (3/2, 2, -1/2), EXT2 (2, -1).
+void BDFCoefficients(int k, const double *dts, double b[max_bdf_order + 1],
+                     double e[max_bdf_order + 1])
+{
+    double tau[max_bdf_order + 1] = {0.0};
+    for (int j = 1; j <= k; j++) { tau[j] = tau[j - 1] - dts[j - 1]; }
+
+    b[0] = 0.0;
+    e[0] = 0.0;
+    for (int m = 1; m <= k; m++) { b[0] += dts[0] / (tau[0] - tau[m]); }
+    for (int j = 1; j <= k; j++)
+    {
+        // Derivative at tau[0] of the j-th basis through tau[0..k]
+        double dl = 1.0 / (tau[j] - tau[0]);
+        // Value at tau[0] of the j-th basis through tau[1..k]
+        e[j] = 1.0;
+        for (int m = 1; m <= k; m++)
+        {
+            if (m == j) { continue; }
+            dl *= (tau[0] - tau[m]) / (tau[j] - tau[m]);
+            e[j] *= (tau[0] - tau[m]) / (tau[j] - tau[m]);
+        }
+        b[j] = -dts[0] * dl;
+    }
+}
+
+// ============================================================================
+// Adaptive Time Stepping
+// ============================================================================
+
+// Largest |u|/h over the mesh, the rate in the convective CFL number
+// dt |u|/h. h is the element's minimal size divided by the order (the node
+// spacing), and |u| is taken at the element's nodes, which for the nodal H1
+// basis are the dof values themselves: no basis evaluation, and one
+// MPI_Allreduce per call.
+class CFLEstimator
+{
+public:
+    CFLEstimator(ParFiniteElementSpace &fes, int order) : comm(fes.GetComm())
+    {
+        ParMesh *pmesh = fes.GetParMesh();
+        Array<int> dofs;
+        offsets.push_back(0);
+        for (int e = 0; e < fes.GetNE(); e++)
+        {
+            fes.GetElementDofs(e, dofs);
+            for (int i = 0; i < dofs.Size(); i++)
+            {
+                dofs_x.push_back(fes.DofToVDof(dofs[i], 0));
+                dofs_y.push_back(fes.DofToVDof(dofs[i], 1));
+            }
+            offsets.push_back((int)dofs_x.size());
+            inv_h.push_back(order / pmesh->GetElementSize(e, 1));
+        }
+    }
+
+    double MaxRate(const ParGridFunction &u) const
+    {
+        double rate = 0.0;
+        for (size_t e = 0; e + 1 < offsets.size(); e++)
+        {
+            double u2 = 0.0;
+            for (int i = offsets[e]; i < offsets[e + 1]; i++)
+            {
+                u2 = max(u2, u(dofs_x[i]) * u(dofs_x[i]) + u(dofs_y[i]) * u(dofs_y[i]));
+            }
+            rate = max(rate, sqrt(u2) * inv_h[e]);
+        }
+        MPI_Allreduce(MPI_IN_PLACE, &rate, 1, MPI_DOUBLE, MPI_MAX, comm);
+        return rate;
+    }
+
+private:
+    MPI_Comm comm;
+    vector<int> offsets, dofs_x, dofs_y;
+    vector<double> inv_h;
+};
+
+// Chooses the next step size from the CFL rate. dt shrinks at once when it
+// would exceed the target CFL, to one growth factor below the limit, and
+// grows by that factor only when the grown step still fits. dt therefore
+// takes few distinct values and H is refreshed rarely.
+class TimeStepController
+{
+public:
+    TimeStepController(double cfl, double growth, double dt_max)
+        : cfl(cfl), growth(growth), dt_max(dt_max) { }
+
+    double Next(double dt, double rate) const
+    {
+        double next = dt;
+        if (rate * dt > cfl) { next = cfl / (rate * growth); }
+        else if (rate * dt * growth <= cfl) { next = dt * growth; }
+        return (dt_max > 0.0) ? min(next, dt_max) : next;
+    }
+
+private:
+    double cfl, growth, dt_max;
+};
+
+// ============================================================================
+// Projection Mass Inverse
+// ============================================================================
+
+// Applies M^{-1} to the discrete gradient in the velocity correction, so that
+// u = u* + (dt/b0) M^{-1} D^T p is a consistent projection. LUMPED uses the
+// row-sum diagonal (one pointwise division); CONSISTENT runs CG on M with the
+// lumped diagonal as preconditioner. NONE keeps the old unscaled update.
+class MassInverse : public Solver
+{
+public:
+    enum Type { NONE = 0, LUMPED = 1, CONSISTENT = 2 };
+
+    MassInverse(int type, const Operator &M, MPI_Comm comm)
+        : Solver(M.Height(), false), type(type), lumped(M.Height()), cg(comm)
+    {
+        Vector ones(height);
+        ones = 1.0;
+        M.Mult(ones, lumped);
+        if (type == CONSISTENT)
+        {
+            jacobi = new OperatorJacobiSmoother(lumped, no_dofs);
+            cg.SetPreconditioner(*jacobi);
+            cg.SetOperator(M);
+            cg.SetMaxIter(100);
+            cg.SetRelTol(1e-10);
+            cg.SetAbsTol(1e-14);
+        }
+    }
+
+    ~MassInverse() { delete jacobi; }
+
+    void SetOperator(const Operator &op) override { }
+
+    void Mult(const Vector &b, Vector &x) const override
+    {
+        if (type == CONSISTENT) { cg.Mult(b, x); }
+        else if (type == LUMPED)
+        {
+            for (int i = 0; i < height; i++) { x(i) = b(i) / lumped(i); }
+        }
+        else { x = b; }
+    }
+
+private:
+    int type;
+    Vector lumped;
+    Array<int> no_dofs;
+    OperatorJacobiSmoother *jacobi = nullptr;
+    CGSolver cg;
+};
+
+// ============================================================================
+// Monolithic Saddle-Point Solver
+// ============================================================================
+
+// Solves the coupled BDF step for velocity and pressure at once instead of
+// splitting it into predictor, Poisson solve and correction:
+//
+//   [ H  -D^T ] [u]   [f]        H = (b0/dt) M + nu K
+//   [ D   0   ] [p] = [g]
+//
+// with FGMRES and the block lower-triangular preconditioner [H 0; D S]^{-1}
+// from the block LU factorization. H^{-1} is one V-cycle of the
+// velocity AMG; the Schur complement S = D H^{-1} D^T is approximated after
+// Cahouet-Chabard by S^{-1} ~ (b0/dt) L^{-1} + nu Mp^{-1}, with the pressure
+// Laplacian L (AMG or the direct solver) and the lumped pressure mass Mp.
+// Velocity Dirichlet dofs are eliminated from D and D^T once; their values
+// enter g through the eliminated columns. There is no splitting error, and
+// the pressure is determined by the do-nothing outflow without a pressure
+// Dirichlet condition.
+class MonolithicSolver
+{
+public:
+    MonolithicSolver(const HypreParMatrix &D, const Array<int> &ess_vel,
+                     const HypreParMatrix &H, double alpha, double nu,
+                     Solver &H_inv, Solver &L_inv, const HypreParMatrix &Mp,
+                     MPI_Comm comm)
+        : offsets(3), mp_inv(MassInverse::LUMPED, Mp, comm),
+          schur(L_inv, mp_inv, alpha, nu), gmres(comm)
+    {
+        offsets[0] = 0;
+        offsets[1] = H.Height();
+        offsets[2] = H.Height() + D.Height();
+        D_e = new HypreParMatrix(D);
+        D_bc = D_e->EliminateCols(ess_vel);
+        G_e = D_e->Transpose();
+
+        block_op = new BlockOperator(offsets);
+        block_op->SetBlock(0, 0, const_cast<HypreParMatrix *>(&H));
+        block_op->SetBlock(0, 1, G_e, -1.0);
+        block_op->SetBlock(1, 0, D_e);
+
+        prec = new BlockLowerTriangularPreconditioner(offsets);
+        prec->SetDiagonalBlock(0, &H_inv);
+        prec->SetDiagonalBlock(1, &schur);
+        prec->SetBlock(1, 0, D_e);
+
+        gmres.SetOperator(*block_op);
+        gmres.SetPreconditioner(*prec);
+        gmres.SetKDim(50);
+        gmres.SetMaxIter(500);
+        gmres.SetRelTol(1e-8);
+        gmres.SetAbsTol(1e-10);
+        gmres.iterative_mode = true;
+
+        B.Update(offsets);
+        X.Update(offsets);
+    }
+
+    ~MonolithicSolver()
+    {
+        delete prec;
+        delete block_op;
+        delete G_e;
+        delete D_bc;
+        delete D_e;
+    }
+
+    // New H = alpha M + nu K (BDF ramp-up, adaptive dt or a new case),
+    // already eliminated
+    void SetMomentumOperator(const HypreParMatrix &H, double alpha, double nu)
+    {
+        block_op->SetBlock(0, 0, const_cast<HypreParMatrix *>(&H));
+        schur.alpha = alpha;
+        schur.nu = nu;
+    }
+
+    // F: momentum right-hand side with the Dirichlet values of U_bc already
+    // eliminated; U_bc also seeds the velocity, P the pressure (in/out)
+    void Mult(const Vector &F, const Vector &U_bc, Vector &U, Vector &P)
+    {
+        B.GetBlock(0) = F;
+        D_bc->Mult(U_bc, B.GetBlock(1));
+        B.GetBlock(1).Neg();
+        X.GetBlock(0) = U_bc;
+        X.GetBlock(1) = P;
+        gmres.Mult(B, X);
+        U = X.GetBlock(0);
+        P = X.GetBlock(1);
+    }
+
+    // Correction of a Newton step: solves with the right-hand side (R_u, R_p),
+    // homogeneous velocity Dirichlet values and a zero initial guess
+    void SolveCorrection(const Vector &R_u, const Vector &R_p, Vector &dU, Vector &dP)
+    {
+        B.GetBlock(0) = R_u;
+        B.GetBlock(1) = R_p;
+        X = 0.0;
+        gmres.Mult(B, X);
+        dU = X.GetBlock(0);
+        dP = X.GetBlock(1);
+    }
+
+    void SetRelTol(double tol) { gmres.SetRelTol(tol); }
+
+    const IterativeSolver &Krylov() const { return gmres; }
+
+private:
+    // S^{-1} ~ alpha L^{-1} + nu Mp^{-1}
+    class SchurInverse : public Solver
+    {
+    public:
+        SchurInverse(Solver &L_inv, Solver &Mp_inv, double alpha, double nu)
+            : Solver(L_inv.Height(), false), alpha(alpha), nu(nu), L_inv(L_inv),
+              Mp_inv(Mp_inv), tmp(L_inv.Height())
+        { }
+
+        void SetOperator(const Operator &op) override { }
+
+        // The steady solve has alpha = 0 and skips the Laplacian solve
+        void Mult(const Vector &b, Vector &x) const override
+        {
+            if (alpha == 0.0)
+            {
+                Mp_inv.Mult(b, x);
+                x *= nu;
+                return;
+            }
+            L_inv.Mult(b, x);
+            Mp_inv.Mult(b, tmp);
+            x *= alpha;
+            x.Add(nu, tmp);
+        }
+
+        double alpha, nu;
+
+    private:
+        Solver &L_inv, &Mp_inv;
+        mutable Vector tmp;
+    };
+
+    Array<int> offsets;
+    HypreParMatrix *D_e, *D_bc, *G_e;
+    MassInverse mp_inv;
+    SchurInverse schur;
+    BlockOperator *block_op;
+    BlockLowerTriangularPreconditioner *prec;
+    FGMRESSolver gmres;
+    BlockVector B, X;
+};
+
+// ============================================================================
+// Steady-State Newton Solver
+// ============================================================================
+
+// Steady Navier-Stokes equations nu K u + N(u) - D^T p = 0, D u = 0 by
+// damped Newton iterations. The Jacobian block nu K + N'(u) is assembled
+// from the convection form's gradient, the pressure coupling reuses D, and
+// each correction is one MonolithicSolver solve (alpha = 0, so its Schur
+// complement approximation is nu Mp^{-1}). The linear tolerance follows
+// Eisenstat-Walker (choice 2), so early iterations are solved loosely. A
+// backtracking line search on |F| makes the iteration robust from the
+// Stokes-like start u = Dirichlet data.
+class SteadySolver
+{
+public:
+    SteadySolver(Profiler &prof, const HypreParMatrix &K, const HypreParMatrix &D,
+                 ParNonlinearForm &conv, double nu, const Array<int> &ess_vel,
+                 Solver &L_inv, const HypreParMatrix &Mp, long mesh_sequence)
+        : prof(prof), K(K), D(D), conv(conv), nu(nu), ess_vel(ess_vel), L_inv(L_inv),
+          Mp(Mp), mesh_sequence(mesh_sequence), comm(K.GetComm()), jac_amg(prof, "jac"),
+          ph_residual(prof.Register("newton_residual")),
+          ph_jacobian(prof.Register("newton_jacobian")),
+          ph_linear(prof.Register("newton_linear_solve", true)),
+          F_u(K.Height()), F_p(D.Height()), N(K.Height()), dU(K.Height()),
+          dP(D.Height()), U_try(K.Height()), P_try(D.Height())
+    { }
+
+    ~SteadySolver()
+    {
+        delete mono;
+        delete J_elim;
+        delete J;
+    }
+
+    void SetTolerances(double rel, double abs, int max_it)
+    {
+        rel_tol = rel;
+        abs_tol = abs;
+        max_iter = max_it;
+    }
+
+    // U holds the Dirichlet values on entry (and an initial guess elsewhere)
+    bool Solve(Vector &U, Vector &P)
+    {
+        double norm = Residual(U, P), norm0 = norm, norm_old = norm, eta = eta_max;
+        linear_its = 0;
+        for (its = 0; its < max_iter; its++)
+        {
+            if (Mpi::Root())
+            {
+                cout << "Newton " << its << ": |F| = " << norm << endl;
+            }
+            if (norm <= max(abs_tol, rel_tol * norm0)) { return true; }
+
+            // Eisenstat-Walker forcing term, safeguarded against dropping
+            // too fast and against over-solving the last iteration
+            if (its > 0)
+            {
+                const double eta_prev = eta;
+                eta = gamma * pow(norm / norm_old, 2);
+                const double eta_floor = gamma * eta_prev * eta_prev;
+                if (eta_floor > 0.1) { eta = max(eta, eta_floor); }
+                eta = max(min(eta, eta_max), 0.5 * abs_tol / norm);
+            }
+
+            Jacobian(U);
+            {
+                ScopedPhase timer(prof, ph_linear);
+                F_u.Neg();
+                F_p.Neg();
+                mono->SetRelTol(eta);
+                mono->SolveCorrection(F_u, F_p, dU, dP);
+                prof.RecordSolve(ph_linear, mono->Krylov());
+                linear_its += mono->Krylov().GetNumIterations();
+            }
+
+            // Backtracking: accept the first step length with sufficient decrease
+            norm_old = norm;
+            double lambda = 1.0;
+            for (int ls = 0; ; ls++)
+            {
+                add(U, lambda, dU, U_try);
+                add(P, lambda, dP, P_try);
+                norm = Residual(U_try, P_try);
+                if (norm < (1.0 - 1e-4 * lambda) * norm_old || ls == max_halvings) { break; }
+                lambda *= 0.5;
+            }
+            U = U_try;
+            P = P_try;
+            if (lambda < 1.0 && Mpi::Root())
+            {
+                cout << "  line search: step " << lambda << endl;
+            }
+        }
+        if (Mpi::Root()) { cout << "Newton " << its << ": |F| = " << norm << endl; }
+        return norm <= max(abs_tol, rel_tol * norm0);
+    }
+
+    // Next Reynolds number (ensemble); U and P of Solve are the warm start
+    void SetViscosity(double new_nu) { nu = new_nu; }
+
+    int Iterations() const { return its; }
+    int LinearIterations() const { return linear_its; }
+
+private:
+    // F = (nu K U + N(U) - D^T P, D U) with zero momentum rows at the
+    // Dirichlet dofs; returns |F|
+    double Residual(const Vector &U, const Vector &P)
+    {
+        ScopedPhase timer(prof, ph_residual);
+        K.Mult(U, F_u);
+        F_u *= nu;
+        conv.Mult(U, N);
+        F_u += N;
+        D.AddMultTranspose(P, F_u, -1.0);
+        F_u.SetSubVector(ess_vel, 0.0);
+        D.Mult(U, F_p);
+        return sqrt(InnerProduct(comm, F_u, F_u) + InnerProduct(comm, F_p, F_p));
+    }
+
+    // J = nu K + N'(U), eliminated, with a new AMG hierarchy
+    void Jacobian(const Vector &U)
+    {
+        {
+            ScopedPhase timer(prof, ph_jacobian);
+            HypreParMatrix &dN = dynamic_cast<HypreParMatrix &>(conv.GetGradient(U));
+            delete J_elim;
+            delete J;
+            J = Add(nu, K, 1.0, dN);
+            J_elim = new EliminatedOperator(*J, ess_vel);
+        }
+        jac_amg.Clear();
+        jac_amg.Update(J_elim->Get(), 0.0, nu, mesh_sequence);
+        if (!mono)
+        {
+            mono = new MonolithicSolver(D, ess_vel, J_elim->Get(), 0.0, nu, jac_amg, L_inv,
+                                        Mp, comm);
+        }
+        else { mono->SetMomentumOperator(J_elim->Get(), 0.0, nu); }
+    }
+
+    Profiler &prof;
+    const HypreParMatrix &K, &D;
+    ParNonlinearForm &conv;
+    double nu;
+    const Array<int> &ess_vel;
+    Solver &L_inv;
+    const HypreParMatrix &Mp;
+    long mesh_sequence;
+    MPI_Comm comm;
+
+    AMGPreconditioner jac_amg;
+    HypreParMatrix *J = nullptr;
+    EliminatedOperator *J_elim = nullptr;
+    MonolithicSolver *mono = nullptr;
+    int ph_residual, ph_jacobian, ph_linear;
+
+    double rel_tol = 1e-8, abs_tol = 1e-10;
+    int max_iter = 30, its = 0, linear_its = 0;
+    const double gamma = 0.9, eta_max = 0.5;
+    const int max_halvings = 8;
+
+    Vector F_u, F_p, N, dU, dP, U_try, P_try;
+};
+
+// ============================================================================
+// Batched Multi-Sample Solves
+// ============================================================================
+
+// Applies a HypreParMatrix to several vectors at once. The vectors are
+// interleaved so that every matrix entry is read once for all of them (a
+// sparse matrix times a tall skinny dense matrix); the mat-vec is bound by
+// the memory traffic of the entries, so this amortizes it over the batch.
+// The halo values of all vectors are exchanged through the matrix's hypre
+// communication package while the local (diag) block is applied.
+class BatchedMatrix
+{
+public:
+    // (Re)bind to A, e.g. after H was rebuilt; buffers are sized for up to
+    // max_vectors vectors and only reallocated when they grow
+    void Bind(const HypreParMatrix &A, int max_vectors)
+    {
+        hypre_ParCSRMatrix *pA = A;
+        diag = hypre_ParCSRMatrixDiag(pA);
+        offd = hypre_ParCSRMatrixOffd(pA);
+        comm_pkg = hypre_ParCSRMatrixCommPkg(pA);
+        if (!comm_pkg)
+        {
+            hypre_MatvecCommPkgCreate(pA);
+            comm_pkg = hypre_ParCSRMatrixCommPkg(pA);
+        }
+        nrows = hypre_CSRMatrixNumRows(diag);
+        ncols = hypre_CSRMatrixNumCols(diag);
+        ncols_offd = hypre_CSRMatrixNumCols(offd);
+        send_len = hypre_ParCSRCommPkgSendMapStart(comm_pkg,
+                                                    hypre_ParCSRCommPkgNumSends(comm_pkg));
+        send_map = hypre_ParCSRCommPkgSendMapElmts(comm_pkg);
+
+        send_buf.SetSize(max_vectors * send_len);
+        recv_buf.SetSize(max_vectors * ncols_offd);
+        x_il.SetSize(max_vectors * max(ncols, ncols_offd));
+        y_il.SetSize(max_vectors * nrows);
+        if ((int)handles.size() < max_vectors) { handles.resize(max_vectors); }
+    }
+
+    // y[v] = A x[v] for v < nv
+    void Mult(int nv, const Vector *const *x, Vector *const *y) const
+    {
+        for (int v = 0; v < nv; v++)
+        {
+            double *sb = send_buf.GetData() + v * send_len;
+            const double *xv = x[v]->GetData();
+            for (int i = 0; i < send_len; i++) { sb[i] = xv[send_map[i]]; }
+            handles[v] = hypre_ParCSRCommHandleCreate(1, comm_pkg, sb,
+                                                      recv_buf.GetData() + v * ncols_offd);
+        }
+
+        // Local block, overlapping the halo exchange
+        Interleave(nv, ncols, x, x_il.GetData());
+        y_il = 0.0;
+        AddSpMM(diag, nv);
+        for (int v = 0; v < nv; v++) { hypre_ParCSRCommHandleDestroy(handles[v]); }
+
+        // Off-processor block from the received halo values
+        if (ncols_offd > 0)
+        {
+            double *xi = x_il.GetData();
+            OMP(omp parallel for schedule(static))
+            for (int i = 0; i < ncols_offd; i++)
+            {
+                for (int v = 0; v < nv; v++)
+                {
+                    xi[i * nv + v] = recv_buf.GetData()[v * ncols_offd + i];
+                }
+            }
+            AddSpMM(offd, nv);
+        }
+
+        const double *yi = y_il.GetData();
+        OMP(omp parallel for schedule(static))
+        for (int i = 0; i < nrows; i++)
+        {
+            for (int v = 0; v < nv; v++) { y[v]->GetData()[i] = yi[i * nv + v]; }
+        }
+    }
+
+private:
+    static void Interleave(int nv, int n, const Vector *const *x, double *out)
+    {
+        OMP(omp parallel for schedule(static))
+        for (int i = 0; i < n; i++)
+        {
+            for (int v = 0; v < nv; v++) { out[i * nv + v] = x[v]->GetData()[i]; }
+        }
+    }
+
+    // y_il += B x_il for a local CSR block
+    void AddSpMM(hypre_CSRMatrix *B, int nv) const
+    {
+        const HYPRE_Int *I = hypre_CSRMatrixI(B), *J = hypre_CSRMatrixJ(B);
+        const double *data = hypre_CSRMatrixData(B);
+        const double *xi = x_il.GetData();
+        double *yi = y_il.GetData();
+        OMP(omp parallel for schedule(static))
+        for (int i = 0; i < nrows; i++)
+        {
+            double *yr = yi + i * nv;
+            for (HYPRE_Int jj = I[i]; jj < I[i + 1]; jj++)
+            {
+                const double a = data[jj];
+                const double *xr = xi + J[jj] * nv;
+                for (int v = 0; v < nv; v++) { yr[v] += a * xr[v]; }
+            }
+        }
+    }
+
+    hypre_CSRMatrix *diag = nullptr, *offd = nullptr;
+    hypre_ParCSRCommPkg *comm_pkg = nullptr;
+    const HYPRE_Int *send_map = nullptr;
+    int nrows = 0, ncols = 0, ncols_offd = 0, send_len = 0;
+    mutable Vector send_buf, recv_buf, x_il, y_il;
+    mutable vector<hypre_ParCSRCommHandle *> handles;
+};
+
+// Throughput of the batched mat-vec for 1..max_batch vectors against the
+// single-vector HypreParMatrix::Mult; prints DOFs/s over all vectors
+void BenchmarkBatchedMatVec(const HypreParMatrix &A, MPI_Comm comm, HYPRE_BigInt dofs,
+                            int reps, int max_batch)
+{
+    BatchedMatrix A_b;
+    A_b.Bind(A, max_batch);
+    vector<Vector> x(max_batch), y(max_batch);
+    Array<Vector *> px(max_batch), py(max_batch);
+    for (int v = 0; v < max_batch; v++)
+    {
+        x[v].SetSize(A.Width());
+        y[v].SetSize(A.Height());
+        x[v].Randomize(v + 1);
+        px[v] = &x[v];
+        py[v] = &y[v];
+    }
+
+    if (Mpi::Root()) { cout << "Batched mat-vec benchmark (" << reps << " applications):\n"; }
+    for (int nv = 0; nv <= max_batch; nv++)
+    {
+        // nv = 0: one plain HypreParMatrix::Mult as the reference
+        auto apply = [&]()
+        {
+            if (nv == 0) { A.Mult(x[0], y[0]); }
+            else { A_b.Mult(nv, px, py); }
+        };
+        apply();  // warm-up
+        MPI_Barrier(comm);
+        double start = MPI_Wtime();
+        for (int r = 0; r < reps; r++) { apply(); }
+        double time = (MPI_Wtime() - start) / reps;
+        MPI_Allreduce(MPI_IN_PLACE, &time, 1, MPI_DOUBLE, MPI_MAX, comm);
+        if (Mpi::Root())
+        {
+            cout << "  " << (nv == 0 ? string("Mult   ") : "K = " + to_string(nv) + "  ")
+                 << 1e3 * time << " ms, " << max(nv, 1) * dofs / time << " DOFs/s" << endl;
+        }
+    }
+}
+
+// Preconditioned CG for several right-hand sides with the same operator, run
+// in lockstep: one batched mat-vec per iteration for all unconverged systems
+// and one MPI_Allreduce per reduction for all of them. Each system keeps its
+// own recurrence and stops on its own (MFEM's CG criterion in the
+// preconditioned norm); the preconditioner is applied per system. The solve
+// starts from the initial guess in x.
+class BatchedCG
+{
+public:
+    BatchedCG(MPI_Comm comm, int nvec, int n)
+        : comm(comm), nvec(nvec), r(nvec), z(nvec), p(nvec), q(nvec),
+          ptr_x(nvec), ptr_y(nvec), nom(nvec), tol(nvec), dots(nvec), idx(nvec),
+          its(nvec), norms(nvec)
+    {
+        for (int s = 0; s < nvec; s++)
+        {
+            r[s].SetSize(n);
+            z[s].SetSize(n);
+            p[s].SetSize(n);
+            q[s].SetSize(n);
+        }
+    }
+
+    void SetOperator(const HypreParMatrix &A) { A_b.Bind(A, nvec); }
+    void SetPreconditioner(Solver &pc) { prec = &pc; }
+
+    void SetTolerances(double rel, double abs, int max_it)
+    {
+        rel_tol = rel;
+        abs_tol = abs;
+        max_iter = max_it;
+    }
+
+    void Mult(Vector *const *b, Vector *const *x)
+    {
+        // r = b - A x, z = P r, p = z
+        A_b.Mult(nvec, x, Ptrs(q, ptr_y));
+        for (int s = 0; s < nvec; s++)
+        {
+            subtract(*b[s], q[s], r[s]);
+            prec->Mult(r[s], z[s]);
+            p[s] = z[s];
+            nom[s] = r[s] * z[s];
+        }
+        MPI_Allreduce(MPI_IN_PLACE, nom.GetData(), nvec, MPI_DOUBLE, MPI_SUM, comm);
+
+        int na = 0;
+        for (int s = 0; s < nvec; s++)
+        {
+            tol[s] = max(rel_tol * sqrt(nom[s]), abs_tol);
+            its[s] = 0;
+            norms[s] = sqrt(max(nom[s], 0.0));
+            if (nom[s] > 0.0 && norms[s] > tol[s]) { idx[na++] = s; }
+        }
+
+        for (int it = 1; it <= max_iter && na > 0; it++)
+        {
+            // q = A p for the unconverged systems
+            for (int a = 0; a < na; a++)
+            {
+                ptr_x[a] = &p[idx[a]];
+                ptr_y[a] = &q[idx[a]];
+            }
+            A_b.Mult(na, ptr_x.GetData(), ptr_y.GetData());
+            for (int a = 0; a < na; a++) { dots[a] = p[idx[a]] * q[idx[a]]; }
+            MPI_Allreduce(MPI_IN_PLACE, dots.GetData(), na, MPI_DOUBLE, MPI_SUM, comm);
+
+            // A system with (p, Ap) <= 0 or (r, z) <= 0 has broken down (e.g.
+            // an exactly zero residual) and is frozen like a converged one; the
+            // former is marked by a negative entry in the second reduction
+            for (int a = 0; a < na; a++)
+            {
+                const int s = idx[a];
+                if (dots[a] <= 0.0)
+                {
+                    dots[a] = -1.0;
+                    continue;
+                }
+                const double alpha = nom[s] / dots[a];
+                x[s]->Add(alpha, p[s]);
+                r[s].Add(-alpha, q[s]);
+                prec->Mult(r[s], z[s]);
+                dots[a] = r[s] * z[s];
+            }
+            MPI_Allreduce(MPI_IN_PLACE, dots.GetData(), na, MPI_DOUBLE, MPI_SUM, comm);
+
+            int nactive = 0;
+            for (int a = 0; a < na; a++)
+            {
+                const int s = idx[a];
+                its[s] = it;
+                if (dots[a] <= 0.0)
+                {
+                    if (dots[a] == 0.0) { norms[s] = 0.0; }
+                    continue;
+                }
+                const double beta = dots[a] / nom[s];
+                nom[s] = dots[a];
+                norms[s] = sqrt(nom[s]);
+                if (norms[s] <= tol[s]) { continue; }
+                add(z[s], beta, p[s], p[s]);
+                idx[nactive++] = s;
+            }
+            na = nactive;
+        }
+    }
+
+    // Largest iteration count and final residual norm over the systems
+    int MaxIterations() const { return its.Max(); }
+    double MaxFinalNorm() const { return norms.Max(); }
+
+private:
+    // Pointer array to all vectors of `vecs`
+    Vector **Ptrs(vector<Vector> &vecs, Array<Vector *> &ptrs)
+    {
+        for (int s = 0; s < nvec; s++) { ptrs[s] = &vecs[s]; }
+        return ptrs.GetData();
+    }
+
+    MPI_Comm comm;
+    int nvec;
+    BatchedMatrix A_b;
+    Solver *prec = nullptr;
+    double rel_tol = 1e-8, abs_tol = 1e-10;
+    int max_iter = 200;
+
+    vector<Vector> r, z, p, q;
+    Array<Vector *> ptr_x, ptr_y;
+    Vector nom, tol, dots;
+    Array<int> idx, its;
+    Vector norms;
+};
+
+// ============================================================================
+// Krylov Initial Guess
+// ============================================================================
+
+// Initial guess for a Krylov solve from the solutions of previous steps.
+// LINEAR and QUADRATIC extrapolate the last 2 or 3 solutions to the new time
+// level with the EXT weights of the actual step sizes. PROJECTION (Fischer's
+// method) keeps an A-orthonormal basis of up to `depth` previous solutions
+// and starts from the A-norm best approximation in their span,
+// x0 = sum_i (x_i, b) x_i. Its basis restarts from the newest solution when
+// full and must be Reset when A changes. All storage is sized here, and
+// each call does one MPI_Allreduce for all of its dot products.
+class InitialGuess
+{
+public:
+    enum Type { ZERO = 0, LINEAR = 1, QUADRATIC = 2, PROJECTION = 3 };
+
+    InitialGuess(int type, int size, int depth, MPI_Comm comm)
+        : type(type), comm(comm), Ax(size)
+    {
+        const int n = (type == PROJECTION) ? depth : (type == ZERO ? 0 : type + 1);
+        basis.resize(n);
+        for (Vector &x : basis) { x.SetSize(size); }
+        dots.resize(n + 1);
+    }
+
+    bool Enabled() const { return type != ZERO; }
+
+    void Reset() { count = 0; }
+
+    // The projection basis is A-orthonormal for one A and is dropped when A
+    // changes; the extrapolation history does not depend on A
+    void OperatorChanged()
+    {
+        if (type == PROJECTION) { count = 0; }
+    }
+
+    // History vectors and the number in use, for checkpointing
+    vector<Vector> &History() { return basis; }
+    int &Count() { return count; }
+
+    // Write the guess into x for the eliminated system A x = b, whose
+    // essential rows are the identity: x(ess) is taken from b
+    void Predict(const double *dts, const Vector &b, Vector &x, const Array<int> &ess) const
+    {
+        if (type == ZERO) { return; }
+        x = 0.0;
+        if (type == PROJECTION)
+        {
+            for (int i = 0; i < count; i++) { dots[i] = basis[i] * b; }
+            MPI_Allreduce(MPI_IN_PLACE, dots.data(), count, MPI_DOUBLE, MPI_SUM, comm);
+            for (int i = 0; i < count; i++) { x.Add(dots[i], basis[i]); }
+        }
+        else if (count > 0)
+        {
+            double bdf[max_bdf_order + 1], ext[max_bdf_order + 1];
+            BDFCoefficients(count, dts, bdf, ext);
+            for (int j = 1; j <= count; j++) { x.Add(ext[j], basis[j - 1]); }
+        }
+        for (int i = 0; i < ess.Size(); i++) { x(ess[i]) = b(ess[i]); }
+    }
+
+    // Add the solution x of A x = b to the history
+    void Store(const Operator &A, const Vector &x)
+    {
+        if (type == ZERO) { return; }
+        if (type != PROJECTION)
+        {
+            for (int j = (int)basis.size() - 1; j > 0; j--) { basis[j].Swap(basis[j - 1]); }
+            basis[0] = x;
+            count = min(count + 1, (int)basis.size());
+            return;
+        }
+
+        // Gram-Schmidt in the A inner product: x_new = x - sum_i (x_i, A x) x_i
+        if (count == (int)basis.size()) { count = 0; }
+        A.Mult(x, Ax);
+        for (int i = 0; i < count; i++) { dots[i] = basis[i] * Ax; }
+        dots[count] = x * Ax;
+        MPI_Allreduce(MPI_IN_PLACE, dots.data(), count + 1, MPI_DOUBLE, MPI_SUM, comm);
+        double norm2 = dots[count];
+        for (int i = 0; i < count; i++) { norm2 -= dots[i] * dots[i]; }
+        if (norm2 <= 1e-12 * dots[count]) { return; }  // x is already in the span
+
+        Vector &x_new = basis[count];
+        x_new = x;
+        for (int i = 0; i < count; i++) { x_new.Add(-dots[i], basis[i]); }
+        x_new *= 1.0 / sqrt(norm2);
+        count++;
+    }
+
+private:
+    int type;
+    MPI_Comm comm;
+    vector<Vector> basis;  // PROJECTION: A-orthonormal; otherwise newest first
+    int count = 0;
+    mutable vector<double> dots;
+    Vector Ax;
+};
+
+// ============================================================================
+// Time-Step Workspace
+// ============================================================================
+
+// Owns every true-dof vector the time loop needs, so a steady-state step
+// performs no heap allocations. U_star and P_new persist between steps (the
+// latter is the true-dof image of p_new) and carry the Dirichlet values;
+// grid functions are synced with GetTrueDofs/Distribute, which write into
+// this storage. U is the corrected velocity u^{n+1}. U_hist and
+// N_hist hold u^n, u^{n-1}, ... and their convection terms (slot 0 newest).
+struct TimeStepWorkspace
+{
+    HypreParVector U_star, RHS_u, N;
+    HypreParVector P_new, RHS_p;
+    Vector U_hist[max_bdf_order], N_hist[max_bdf_order];
+    Vector U_bdf, U, P, Gp, dU;
+
+    TimeStepWorkspace(ParFiniteElementSpace &fes_vel, ParFiniteElementSpace &fes_pres)
+        : U_star(&fes_vel), RHS_u(&fes_vel), N(&fes_vel),
+          P_new(&fes_pres), RHS_p(&fes_pres),
+          U_bdf(fes_vel.GetTrueVSize()), U(fes_vel.GetTrueVSize()),
+          P(fes_pres.GetTrueVSize()), Gp(fes_vel.GetTrueVSize()),
+          dU(fes_vel.GetTrueVSize())
+    {
+        for (int j = 0; j < max_bdf_order; j++)
+        {
+            U_hist[j].SetSize(fes_vel.GetTrueVSize());
+            N_hist[j].SetSize(fes_vel.GetTrueVSize());
+            U_hist[j] = 0.0;
+            N_hist[j] = 0.0;
+        }
+        P = 0.0;
+    }
+
+    // Recycle the oldest buffers into slot 0 for the new newest state
+    void ShiftHistory()
+    {
+        for (int j = max_bdf_order - 1; j > 0; j--)
+        {
+            U_hist[j].Swap(U_hist[j - 1]);
+            N_hist[j].Swap(N_hist[j - 1]);
+        }
+    }
+};
+
+// ============================================================================
+// Parallel Mesh Setup
+// ============================================================================
+
+// Partition a serial mesh that exists only on rank 0 and hand each rank its
+// piece. Rank 0 partitions with METIS through MeshPartitioner, serializes one
+// part at a time in the parallel mesh format and sends it; every rank builds
+// its ParMesh from that stream. No other rank ever holds the global mesh, and
+// rank 0 holds the global mesh plus one part. `serial` is ignored off-root.
+ParMesh *ScatterMesh(MPI_Comm comm, Mesh *serial)
+{
+    int rank, nranks;
+    MPI_Comm_rank(comm, &rank);
+    MPI_Comm_size(comm, &nranks);
+
+    string my_part;
+    if (rank == 0)
+    {
+        MeshPartitioner partitioner(*serial, nranks);
+        for (int r = nranks - 1; r >= 0; r--)
+        {
+            MeshPart part;
+            partitioner.ExtractPart(r, part);
+            ostringstream os;
+            os.precision(16);
+            part.Print(os);
+            if (r == 0)
+            {
+                my_part = os.str();
+                break;
+            }
+            const string buf = os.str();
+            long long len = buf.size();
+            MPI_Send(&len, 1, MPI_LONG_LONG, r, 0, comm);
+            MPI_Send(buf.data(), (int)len, MPI_CHAR, r, 1, comm);
+        }
+    }
+    else
+    {
+        long long len;
+        MPI_Recv(&len, 1, MPI_LONG_LONG, 0, 0, comm, MPI_STATUS_IGNORE);
+        my_part.resize(len);
+        MPI_Recv(&my_part[0], (int)len, MPI_CHAR, 0, 1, comm, MPI_STATUS_IGNORE);
+    }
+
+    istringstream is(my_part);
+    return new ParMesh(comm, is);
+}
+
+// Pre-partitioned meshes: one <prefix>.<rank> file per rank in the parallel
+// mesh format, reloadable on the same number of ranks without partitioning
+void SavePartitionedMesh(const ParMesh &pmesh, const string &prefix)
+{
+    ofstream out(MakeParFilename(prefix + ".", pmesh.GetMyRank()));
+    out.precision(16);
+    pmesh.ParPrint(out);
+}
+
+ParMesh *LoadPartitionedMesh(MPI_Comm comm, const string &prefix)
+{
+    int rank;
+    MPI_Comm_rank(comm, &rank);
+    const string file = MakeParFilename(prefix + ".", rank);
+    ifstream in(file);
+    MFEM_VERIFY(in, "Cannot open partitioned mesh " << file
+                << " (it must be written with the same number of ranks)");
+    return new ParMesh(comm, in);
+}
+
+// ============================================================================
+// O-Grid Mesh Generator
+// ============================================================================
+
+// Body-fitted mesh of the channel [-5, 15] x [-5, 5] around the cylinder of
+// diameter 1 at the origin, defined on logical coordinates (eta, s):
+//   O-block  eta in [0, 1], s in [0, 4]: eta = 0 is the cylinder, eta = 1 the
+//            square [-5, 5]^2 with one unit of s per side (periodic in s)
+//   wake     eta in [1, 2], s in [1, 2]: the Cartesian block [5, 15] x [-5, 5]
+//            attached to the right side of the square
+// Inside the O-block a grid line of constant s runs from the circle to the
+// square, with exponential grading that clusters elements at the cylinder.
+void OGridMap(double eta, double s, double grading, double &x, double &y)
+{
+    const double R = 0.5, L = 5.0, W = 10.0;  // radius, half box width, wake length
+    if (eta > 1.0)
+    {
+        x = L + W * (eta - 1.0);
+        y = -L + 2.0 * L * (s - 1.0);
+        return;
+    }
+
+    const double g = (grading > 0.0) ? expm1(grading * eta) / expm1(grading) : eta;
+    const double theta = -0.75 * M_PI + 0.5 * M_PI * s;
+    const double corners[5][2] = {{-L, -L}, {L, -L}, {L, L}, {-L, L}, {-L, -L}};
+    const int side = min(max((int)floor(s), 0), 3);
+    const double a = s - side;
+    const double sq_x = (1.0 - a) * corners[side][0] + a * corners[side + 1][0];
+    const double sq_y = (1.0 - a) * corners[side][1] + a * corners[side + 1][1];
+    x = (1.0 - g) * R * cos(theta) + g * sq_x;
+    y = (1.0 - g) * R * sin(theta) + g * sq_y;
+}
+
+// Build the O-grid directly as a ParMesh: a coarse logical mesh with n
+// elements per side of the square (n radially, 2n along the wake) is made
+// periodic in s, partitioned, refined par_ref times in parallel, and only
+// then mapped node by node to physical space with continuous H1 nodes of the
+// given order. The cylinder is therefore curved at the FE order on the
+// final mesh. Boundary attributes: 1 cylinder, 2 inlet, 3 outlet, 4 walls.
+ParMesh *GenerateOGridMesh(MPI_Comm comm, int n, double grading, int par_ref, int order)
+{
+    const int ns = 4 * n, nr = n, nw = 2 * n;
+    const int nv_o = (ns + 1) * (nr + 1);
+    // O-block vertex (i, j), i along s (i = ns duplicates i = 0), j along eta
+    auto ov = [&](int i, int j) { return j * (ns + 1) + i; };
+    // Wake vertex (i, j), i = n..2n along s, j = 0..nw (j = 0 is the O-block rim)
+    auto wv = [&](int i, int j) { return j == 0 ? ov(i, nr) : nv_o + (j - 1) * (n + 1) + i - n; };
+
+    Mesh mesh(2, nv_o + nw * (n + 1), ns * nr + n * nw, 12 * n);
+    for (int j = 0; j <= nr; j++)
+    {
+        for (int i = 0; i <= ns; i++) { mesh.AddVertex(double(j) / nr, double(i) / n); }
+    }
+    for (int j = 1; j <= nw; j++)
+    {
+        for (int i = n; i <= 2 * n; i++) { mesh.AddVertex(1.0 + double(j) / nw, double(i) / n); }
+    }
+
+    // Counter-clockwise in the (eta, s) plane, which the map keeps positive
+    for (int j = 0; j < nr; j++)
+    {
+        for (int i = 0; i < ns; i++)
+        {
+            mesh.AddQuad(ov(i, j), ov(i, j + 1), ov(i + 1, j + 1), ov(i + 1, j));
+        }
+    }
+    for (int j = 0; j < nw; j++)
+    {
+        for (int i = n; i < 2 * n; i++)
+        {
+            mesh.AddQuad(wv(i, j), wv(i, j + 1), wv(i + 1, j + 1), wv(i + 1, j));
+        }
+    }
+
+    for (int i = 0; i < ns; i++)
+    {
+        mesh.AddBdrSegment(ov(i, 0), ov(i + 1, 0), 1);
+        const int side = i / n;  // 0 bottom, 1 wake interface, 2 top, 3 inlet
+        if (side != 1) { mesh.AddBdrSegment(ov(i, nr), ov(i + 1, nr), side == 3 ? 2 : 4); }
+    }
+    for (int i = n; i < 2 * n; i++) { mesh.AddBdrSegment(wv(i, nw), wv(i + 1, nw), 3); }
+    for (int j = 0; j < nw; j++)
+    {
+        mesh.AddBdrSegment(wv(n, j), wv(n, j + 1), 4);
+        mesh.AddBdrSegment(wv(2 * n, j), wv(2 * n, j + 1), 4);
+    }
+    mesh.FinalizeQuadMesh(1, 1, true);
+
+    // Identify s = 4 with s = 0; the periodic mesh carries discontinuous
+    // nodes that keep the logical coordinates on both sides of the seam
+    vector<int> v2v(mesh.GetNV());
+    for (int v = 0; v < (int)v2v.size(); v++) { v2v[v] = v; }
+    for (int j = 0; j <= nr; j++) { v2v[ov(ns, j)] = ov(0, j); }
+    Mesh periodic = Mesh::MakePeriodic(mesh, v2v);
+
+    int nranks;
+    MPI_Comm_size(comm, &nranks);
+    while (periodic.GetNE() < nranks) { periodic.UniformRefinement(); }
+
+    ParMesh *pmesh = new ParMesh(comm, periodic);
+    for (int l = 0; l < par_ref; l++) { pmesh->UniformRefinement(); }
+
+    // Evaluate the (element-wise bilinear) logical coordinates at the H1
+    // nodes of each element and map them to physical space
+    const GridFunction *logical = pmesh->GetNodes();
+    H1_FECollection *fec = new H1_FECollection(order, 2);
+    ParFiniteElementSpace *fes = new ParFiniteElementSpace(pmesh, fec, 2, Ordering::byVDIM);
+    ParGridFunction *nodes = new ParGridFunction(fes);
+    nodes->MakeOwner(fec);
+    Array<int> vdofs;
+    Vector es(2);
+    for (int e = 0; e < pmesh->GetNE(); e++)
+    {
+        const IntegrationRule &ir = fes->GetFE(e)->GetNodes();
+        fes->GetElementVDofs(e, vdofs);
+        const int nd = ir.GetNPoints();
+        for (int i = 0; i < nd; i++)
+        {
+            logical->GetVectorValue(e, ir.IntPoint(i), es);
+            OGridMap(es(0), es(1), grading, (*nodes)(vdofs[i]), (*nodes)(vdofs[nd + i]));
+        }
+    }
+    pmesh->NewNodes(*nodes, true);
+    // The vertices still hold logical coordinates; move them onto the
+    // mapped nodes for vertex-based code (ParaView, partitioning, centroids)
+    pmesh->SetVerticesFromNodes(pmesh->GetNodes());
+    return pmesh;
+}
+
+// ============================================================================
+// Checkpoint/Restart
+// ============================================================================
+
+// Parallel checkpoints of the time-loop state: step, t, the dt history, a
+// list of registered scalars (operator coefficients, history counts) and a
+// list of registered true-dof vectors (velocity, BDF/EXT history, pressure,
+// Krylov guesses). Every rank writes <dir>/ckpt_<step>/rank_<r>.bin holding
+//   header: "NSCKPT02", int32 nranks, rank, bdf_order, step, nfields,
+//           nscalars, double t, dt_hist[max_bdf_order], each scalar,
+//           int64 size of each field
+//   its true-dof values of each field
+//   int64 ne, then per element the centroid and the element dof values of
+//   each field (used only to redistribute onto a different rank count)
+// The directory is written as ckpt_<step>.tmp and renamed once every rank
+// has written and fsynced its file; <dir>/latest is then replaced by rename,
+// so a crash during a write leaves the previous checkpoint intact. A failed
+// write or sync is reported and leaves <dir>/latest unchanged. Only the
+// newest `keep` checkpoints are retained.
+class Checkpoint
+{
+public:
+    Checkpoint(MPI_Comm comm, const string &dir, int keep,
+               ParFiniteElementSpace &fes_vel, ParFiniteElementSpace &fes_pres)
+        : comm(comm), dir(dir), keep(max(keep, 1)), fes_vel(fes_vel), fes_pres(fes_pres)
+    {
+        MPI_Comm_rank(comm, &rank);
+        MPI_Comm_size(comm, &nranks);
+    }
+
+    // Add a true-dof vector of the velocity (or pressure) space to the state
+    void Register(Vector &v, bool velocity) { fields.push_back({&v, velocity}); }
+
+    // Add a scalar to the state; counts are stored exactly as doubles
+    void Register(double &x) { scalars.push_back({&x, nullptr}); }
+    void Register(int &n) { scalars.push_back({nullptr, &n}); }
+
+    void Save(int step, double t, const double *dt_hist, int bdf_order)
+    {
+        const string name = "ckpt_" + to_string(step);
+        const string tmp = dir + "/" + name + ".tmp";
+        if (rank == 0)
+        {
+            filesystem::remove_all(tmp);
+            filesystem::create_directories(tmp);
+        }
+        MPI_Barrier(comm);
+
+        const string file = tmp + "/" + RankFile(rank);
+        int ok = WriteRank(file, step, t, dt_hist, bdf_order) && SyncPath(file);
+        MPI_Allreduce(MPI_IN_PLACE, &ok, 1, MPI_INT, MPI_MIN, comm);
+        if (!ok)
+        {
+            if (rank == 0) { cout << "Warning: checkpoint " << name << " failed" << endl; }
+            return;
+        }
+
+        // Each rename is only done once what it publishes is on disk: the
+        // rank files (synced above) and the directory entries that name them
+        if (rank == 0)
+        {
+            error_code ec;
+            filesystem::remove_all(dir + "/" + name, ec);
+            bool published = SyncPath(tmp);
+            if (published)
+            {
+                filesystem::rename(tmp, dir + "/" + name, ec);
+                published = !ec && SyncPath(dir);
+            }
+            if (published)
+            {
+                ofstream latest(dir + "/latest.tmp");
+                latest << name << "\n";
+                latest.close();
+                published = latest.good() && SyncPath(dir + "/latest.tmp");
+            }
+            if (published)
+            {
+                filesystem::rename(dir + "/latest.tmp", dir + "/latest", ec);
+                published = !ec && SyncPath(dir);
+            }
+            if (published) { Prune(); }
+            else
+            {
+                cout << "Warning: checkpoint " << name << " could not be published, "
+                     << dir << "/latest is unchanged" << endl;
+            }
+        }
+    }
+
+    // Restore the checkpoint named in <dir>/latest. Returns false if there is
+    // none. On the same rank count each rank reads back its own true dofs;
+    // otherwise elements are matched by centroid across all old rank files.
+    bool Load(int &step, double &t, double *dt_hist, int bdf_order)
+    {
+        string name;
+        if (rank == 0)
+        {
+            ifstream latest(dir + "/latest");
+            latest >> name;
+        }
+        int len = name.size();
+        MPI_Bcast(&len, 1, MPI_INT, 0, comm);
+        if (len == 0) { return false; }
+        name.resize(len);
+        MPI_Bcast(&name[0], len, MPI_CHAR, 0, comm);
+        const string path = dir + "/" + name + "/";
+
+        Header h0;
+        {
+            ifstream in(path + RankFile(0), ios::binary);
+            MFEM_VERIFY(ReadHeader(in, h0), "Invalid checkpoint " << path);
+        }
+        MFEM_VERIFY(h0.bdf_order == bdf_order, "Checkpoint was written with -bdf "
+                    << h0.bdf_order);
+        MFEM_VERIFY(h0.sizes.size() == fields.size() && h0.scalars.size() == scalars.size(),
+                    "Checkpoint field count mismatch (different -ig or -igd?)");
+        step = h0.step;
+        t = h0.t;
+        for (int j = 0; j < max_bdf_order; j++) { dt_hist[j] = h0.dt_hist[j]; }
+        for (size_t i = 0; i < scalars.size(); i++)
+        {
+            if (scalars[i].x) { *scalars[i].x = h0.scalars[i]; }
+            else { *scalars[i].n = (int)h0.scalars[i]; }
+        }
+
+        if (h0.nranks == nranks) { ReadOwn(path + RankFile(rank)); }
+        else { Redistribute(path, h0.nranks); }
+
+        if (rank == 0)
+        {
+            cout << "Restarted from " << path << " at step " << step << ", t = " << t;
+            if (h0.nranks != nranks) { cout << " (redistributed from " << h0.nranks << " ranks)"; }
+            cout << endl;
+        }
+        return true;
+    }
+
+private:
+    struct Field
+    {
+        Vector *v;
+        bool velocity;
+    };
+
+    struct Scalar
+    {
+        double *x;
+        int *n;
+    };
+
+    struct Header
+    {
+        int nranks, rank, bdf_order, step, nfields, nscalars;
+        double t, dt_hist[max_bdf_order];
+        vector<double> scalars;
+        vector<int64_t> sizes;
+    };
+
+    // fsync a file or directory; false if it cannot be opened or synced
+    static bool SyncPath(const string &path)
+    {
+        const int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0) { return false; }
+        const bool synced = (fsync(fd) == 0);
+        return (close(fd) == 0) && synced;
+    }
+
+    static string RankFile(int r)
+    {
+        char buf[32];
+        snprintf(buf, sizeof(buf), "rank_%06d.bin", r);
+        return buf;
+    }
+
+    ParFiniteElementSpace &Space(const Field &f) { return f.velocity ? fes_vel : fes_pres; }
+
+    // Element-wise values of field f on element e (prolongated to L-dofs)
+    void ElementValues(const Field &f, const Vector &L, int e, Vector &vals)
+    {
+        Space(f).GetElementVDofs(e, vdofs);
+        L.GetSubVector(vdofs, vals);
+    }
+
+    int WriteRank(const string &file, int step, double t, const double *dt_hist,
+                  int bdf_order)
+    {
+        ofstream out(file, ios::binary);
+        const char magic[8] = {'N', 'S', 'C', 'K', 'P', 'T', '0', '2'};
+        const int32_t ints[6] = {nranks, rank, bdf_order, step, (int32_t)fields.size(),
+                                 (int32_t)scalars.size()};
+        out.write(magic, sizeof(magic));
+        out.write((const char *)ints, sizeof(ints));
+        out.write((const char *)&t, sizeof(double));
+        out.write((const char *)dt_hist, max_bdf_order * sizeof(double));
+        for (const Scalar &s : scalars)
+        {
+            const double x = s.x ? *s.x : *s.n;
+            out.write((const char *)&x, sizeof(x));
+        }
+        for (const Field &f : fields)
+        {
+            const int64_t n = f.v->Size();
+            out.write((const char *)&n, sizeof(n));
+        }
+        for (const Field &f : fields)
+        {
+            out.write((const char *)f.v->GetData(), f.v->Size() * sizeof(double));
+        }
+
+        // Element section for redistribution
+        vector<Vector> L(fields.size());
+        for (size_t i = 0; i < fields.size(); i++)
+        {
+            L[i].SetSize(Space(fields[i]).GetVSize());
+            Space(fields[i]).GetProlongationMatrix()->Mult(*fields[i].v, L[i]);
+        }
+        ParMesh *pmesh = fes_vel.GetParMesh();
+        const int64_t ne = pmesh->GetNE();
+        out.write((const char *)&ne, sizeof(ne));
+        Vector center, vals;
+        for (int e = 0; e < ne; e++)
+        {
+            pmesh->GetElementCenter(e, center);
+            out.write((const char *)center.GetData(), 2 * sizeof(double));
+            for (size_t i = 0; i < fields.size(); i++)
+            {
+                ElementValues(fields[i], L[i], e, vals);
+                out.write((const char *)vals.GetData(), vals.Size() * sizeof(double));
+            }
+        }
+        out.close();
+        return out.good() ? 1 : 0;
+    }
+
+    bool ReadHeader(istream &in, Header &h)
+    {
+        char magic[8];
+        int32_t ints[6];
+        in.read(magic, sizeof(magic));
+        in.read((char *)ints, sizeof(ints));
+        in.read((char *)&h.t, sizeof(double));
+        in.read((char *)h.dt_hist, max_bdf_order * sizeof(double));
+        if (!in || string(magic, 8) != "NSCKPT02") { return false; }
+        h.nranks = ints[0];
+        h.rank = ints[1];
+        h.bdf_order = ints[2];
+        h.step = ints[3];
+        h.nfields = ints[4];
+        h.nscalars = ints[5];
+        h.scalars.resize(h.nscalars);
+        in.read((char *)h.scalars.data(), h.nscalars * sizeof(double));
+        h.sizes.resize(h.nfields);
+        in.read((char *)h.sizes.data(), h.nfields * sizeof(int64_t));
+        return bool(in);
+    }
+
+    void ReadOwn(const string &file)
+    {
+        ifstream in(file, ios::binary);
+        Header h;
+        MFEM_VERIFY(ReadHeader(in, h) && h.rank == rank, "Invalid checkpoint " << file);
+        for (size_t i = 0; i < fields.size(); i++)
+        {
+            MFEM_VERIFY(h.sizes[i] == fields[i].v->Size(),
+                        "Checkpoint does not match this mesh/partition: " << file);
+            in.read((char *)fields[i].v->GetData(), h.sizes[i] * sizeof(double));
+        }
+        MFEM_VERIFY(in, "Truncated checkpoint " << file);
+    }
+
+    static pair<long long, long long> Key(const double *c)
+    {
+        return make_pair(llround(c[0] * 1e10), llround(c[1] * 1e10));
+    }
+
+    void Redistribute(const string &path, int old_nranks)
+    {
+        ParMesh *pmesh = fes_vel.GetParMesh();
+        if (pmesh->GetNE() == 0) { return; }
+        map<pair<long long, long long>, int> local;
+        Vector center;
+        for (int e = 0; e < pmesh->GetNE(); e++)
+        {
+            pmesh->GetElementCenter(e, center);
+            local[Key(center.GetData())] = e;
+        }
+
+        vector<Vector> L(fields.size());
+        vector<int> elem_size(fields.size());
+        for (size_t i = 0; i < fields.size(); i++)
+        {
+            L[i].SetSize(Space(fields[i]).GetVSize());
+            L[i] = 0.0;
+            Space(fields[i]).GetElementVDofs(0, vdofs);
+            elem_size[i] = vdofs.Size();
+        }
+
+        int found = 0;
+        Vector vals;
+        for (int r = 0; r < old_nranks; r++)
+        {
+            ifstream in(path + RankFile(r), ios::binary);
+            Header h;
+            MFEM_VERIFY(ReadHeader(in, h), "Invalid checkpoint " << path << RankFile(r));
+            int64_t skip = 0;
+            for (int64_t n : h.sizes) { skip += n; }
+            in.seekg(skip * sizeof(double), ios::cur);
+
+            int64_t ne;
+            in.read((char *)&ne, sizeof(ne));
+            double c[2];
+            for (int64_t e = 0; e < ne; e++)
+            {
+                in.read((char *)c, sizeof(c));
+                auto it = local.find(Key(c));
+                for (size_t i = 0; i < fields.size(); i++)
+                {
+                    vals.SetSize(elem_size[i]);
+                    in.read((char *)vals.GetData(), elem_size[i] * sizeof(double));
+                    if (it == local.end()) { continue; }
+                    Space(fields[i]).GetElementVDofs(it->second, vdofs);
+                    L[i].SetSubVector(vdofs, vals);
+                }
+                if (it != local.end()) { found++; }
+            }
+            MFEM_VERIFY(in, "Truncated checkpoint " << path << RankFile(r));
+        }
+        MFEM_VERIFY(found == pmesh->GetNE(), "Checkpoint is missing " << pmesh->GetNE() - found
+                    << " elements of rank " << rank);
+
+        for (size_t i = 0; i < fields.size(); i++)
+        {
+            Space(fields[i]).GetRestrictionMatrix()->Mult(L[i], *fields[i].v);
+        }
+    }
+
+    // Remove all but the newest `keep` completed checkpoints
+    void Prune()
+    {
+        vector<pair<int, string>> done;
+        for (const auto &entry : filesystem::directory_iterator(dir))
+        {
+            const string name = entry.path().filename().string();
+            if (name.rfind("ckpt_", 0) != 0 || name.find(".tmp") != string::npos) { continue; }
+            done.push_back(make_pair(atoi(name.c_str() + 5), name));
+        }
+        sort(done.begin(), done.end());
+        for (int i = 0; i + keep < (int)done.size(); i++)
+        {
+            filesystem::remove_all(dir + "/" + done[i].second);
+        }
+    }
+
+    MPI_Comm comm;
+    int rank, nranks;
+    string dir;
+    int keep;
+    ParFiniteElementSpace &fes_vel, &fes_pres;
+    vector<Field> fields;
+    vector<Scalar> scalars;
+    Array<int> vdofs;
+};
+
 // ============================================================================
 // Main Solver
 // ============================================================================
 
 int main(int argc, char *argv[])
 {
-    // Initialize MPI
-    Mpi::Init(argc, argv);
+    // Initialize MPI; with -nt > 1 only the main thread makes MPI calls
+    int mpi_thread_level;
+    Mpi::Init(argc, argv, MPI_THREAD_FUNNELED, &mpi_thread_level);
     Hypre::Init();
 
     // Parse command line
@@ -30,14 +2921,168 @@ int main(int argc, char *argv[])
     double dt = 0.01;
     double t_final = 0.2;
     int vis_steps = 5;
+    bool cache_operators = true;
+    int grad_mode = 0;
+    bool count_allocs = false;
+    const char *profile_csv = "";
+    int force_method = 0;
+    int conv_mode = 1;
+    int conv_bench = 0;
+    bool pa = false;
+    int pa_prec = PAPreconditioner::LOR_AMG;
+    int matvec_bench = 0;
+    int bdf_order = 1;
+    int mass_inv_type = MassInverse::LUMPED;
+    int force_format = TimeSeriesWriter::TSV;
+    int force_buffer = 64;
+    bool force_async = false;
+    int pv_steps = 0;
+    int checkpoint_steps = 0;
+    const char *checkpoint_dir = "checkpoint";
+    int checkpoint_keep = 2;
+    bool restart = false;
+    int mesh_mode = 1;
+    const char *mesh_save_prefix = "";
+    bool ogrid = false;
+    int ogrid_n = 8;
+    double ogrid_grading = 3.0;
+    int par_ref = 1;
+    int pv_compress = 0;
+    bool pv_float32 = false;
+    double cfl_target = 0.0;
+    double dt_growth = 1.1;
+    double dt_max = 0.0;
+    double prec_rebuild_tol = 0.2;
+    int guess_type = InitialGuess::ZERO;
+    int guess_depth = 8;
+    int pres_direct_type = 0;
+    bool monolithic = false;
+    bool steady = false;
+    double steady_tol = 1e-8;
+    int steady_max_iter = 30;
+    const char *ensemble_Re = "";
+    const char *ensemble_dt = "";
+    int batch = 1;
+    double batch_amp = 0.05;
+    const char *timing_json = "";
+    int num_threads = 1;
 
     OptionsParser args(argc, argv);
-    args.AddOption(&mesh_file, "-m", "--mesh", "Mesh file");
+    args.AddOption(&mesh_file, "-m", "--mesh",
+                   "Mesh file (with -mm 2: prefix of the pre-partitioned files)");
+    args.AddOption(&mesh_mode, "-mm", "--mesh-mode",
+                   "Mesh setup: 0 = every rank reads and partitions the mesh, "
+                   "1 = rank 0 reads, partitions and scatters, "
+                   "2 = load pre-partitioned <mesh>.<rank> files");
+    args.AddOption(&mesh_save_prefix, "-msave", "--mesh-save",
+                   "Also save the partitioned mesh as <prefix>.<rank> files");
+    args.AddOption(&ogrid, "-og", "--ogrid", "-no-og", "--no-ogrid",
+                   "Generate a body-fitted O-grid instead of reading -m");
+    args.AddOption(&ogrid_n, "-ogn", "--ogrid-n",
+                   "O-grid coarse elements per side of the inner square (n radially, "
+                   "2n in the wake)");
+    args.AddOption(&ogrid_grading, "-ogg", "--ogrid-grading",
+                   "O-grid radial grading toward the cylinder (0 = uniform)");
+    args.AddOption(&par_ref, "-rp", "--refine-parallel",
+                   "O-grid uniform refinements after partitioning");
     args.AddOption(&order, "-o", "--order", "FE order");
     args.AddOption(&Re, "-Re", "--reynolds", "Reynolds number");
     args.AddOption(&dt, "-dt", "--time-step", "Time step");
     args.AddOption(&t_final, "-t", "--final-time", "Final time");
+    args.AddOption(&cfl_target, "-cfl", "--cfl-target",
+                   "Adapt dt to this convective CFL number (0 = fixed dt; -dt is then "
+                   "the initial step)");
+    args.AddOption(&dt_growth, "-dtg", "--dt-growth",
+                   "Largest factor by which the adaptive dt grows per change");
+    args.AddOption(&dt_max, "-dtmax", "--dt-max", "Upper bound of the adaptive dt (0 = none)");
+    args.AddOption(&prec_rebuild_tol, "-prt", "--precond-rebuild-tol",
+                   "With -cfl, rebuild the velocity preconditioner only when b0/dt "
+                   "drifts by more than this fraction from its setup value (the "
+                   "-pa Chebyshev smoother is rebuilt at every change)");
     args.AddOption(&vis_steps, "-vs", "--vis-steps", "Output frequency");
+    args.AddOption(&cache_operators, "-oc", "--op-cache", "-no-oc", "--no-op-cache",
+                   "Eliminate Dirichlet BCs from H and S once and reuse them every step");
+    args.AddOption(&grad_mode, "-grad", "--gradient-mode",
+                   "Gradient in the correction: 0 = G = D^T assembled once, "
+                   "1 = D->MultTranspose, 2 = D->Transpose() every step (legacy)");
+    args.AddOption(&count_allocs, "-ca", "--count-allocs", "-no-ca", "--no-count-allocs",
+                   "Fail if the steady-state time loop performs heap allocations");
+    args.AddOption(&profile_csv, "-pcsv", "--profile-csv",
+                   "Write per-step phase times, iterations and residuals to this CSV file");
+    args.AddOption(&force_method, "-fm", "--force-method",
+                   "Drag/lift evaluation: 0 = surface traction, 1 = volume residual");
+    args.AddOption(&conv_mode, "-conv", "--convection",
+                   "Convection term: 0 = off (Stokes), 1 = explicit kernel, "
+                   "2 = ParNonlinearForm (reference)");
+    args.AddOption(&conv_bench, "-cb", "--conv-bench",
+                   "Benchmark the convection kernel against ParNonlinearForm "
+                   "with this many applications (0 = off)");
+    args.AddOption(&pa, "-pa", "--partial-assembly", "-no-pa", "--no-partial-assembly",
+                   "Apply M, K, S, D and H matrix-free with partial assembly");
+    args.AddOption(&pa_prec, "-pap", "--pa-precond",
+                   "Preconditioner with -pa: 0 = Jacobi, 1 = Chebyshev, 2 = LOR-AMG");
+    args.AddOption(&bdf_order, "-bdf", "--bdf-order",
+                   "Time integration order: BDFk for the time derivative with EXTk "
+                   "convection, k = 1, 2, 3");
+    args.AddOption(&mass_inv_type, "-mi", "--mass-inverse",
+                   "Mass matrix in the velocity correction: 0 = none (unscaled), "
+                   "1 = lumped, 2 = consistent (CG)");
+    args.AddOption(&force_format, "-ff", "--force-format",
+                   "Force history format: 0 = TSV (forces_simple.dat), "
+                   "1 = binary (forces_simple.bin)");
+    args.AddOption(&force_buffer, "-fbuf", "--force-buffer",
+                   "Number of force records buffered before each write");
+    args.AddOption(&force_async, "-fa", "--force-async", "-no-fa", "--no-force-async",
+                   "Write the force history from a helper thread");
+    args.AddOption(&pv_steps, "-pv", "--paraview-steps",
+                   "Write u, p and vorticity for ParaView every this many steps (0 = off)");
+    args.AddOption(&pv_compress, "-pvz", "--paraview-compress",
+                   "zlib compression level of the ParaView output, 0-9 (0 = off)");
+    args.AddOption(&pv_float32, "-pvf", "--paraview-float32", "-no-pvf",
+                   "--no-paraview-float32", "Write ParaView data as float32");
+    args.AddOption(&checkpoint_steps, "-ck", "--checkpoint-steps",
+                   "Write a checkpoint every this many steps (0 = off)");
+    args.AddOption(&checkpoint_dir, "-ckdir", "--checkpoint-dir", "Checkpoint directory");
+    args.AddOption(&checkpoint_keep, "-ckkeep", "--checkpoint-keep",
+                   "Number of checkpoints to keep");
+    args.AddOption(&restart, "-r", "--restart", "-no-r", "--no-restart",
+                   "Continue from the latest checkpoint in the checkpoint directory");
+    args.AddOption(&guess_type, "-ig", "--initial-guess",
+                   "Krylov initial guess from previous steps: 0 = zero, 1 = linear, "
+                   "2 = quadratic extrapolation, 3 = projection (Fischer)");
+    args.AddOption(&guess_depth, "-igd", "--initial-guess-depth",
+                   "Number of previous solutions kept by the projection guess");
+    args.AddOption(&pres_direct_type, "-pds", "--pressure-direct",
+                   "Factor the pressure Laplacian once and solve directly: 0 = off "
+                   "(AMG-CG), 1 = MUMPS, 2 = SuperLU_DIST, 3 = STRUMPACK");
+    args.AddOption(&num_threads, "-nt", "--threads",
+                   "OpenMP threads per rank for assembly, the convection kernel, "
+                   "vector updates and hypre");
+    args.AddOption(&monolithic, "-mono", "--monolithic", "-no-mono", "--no-monolithic",
+                   "Solve the coupled velocity-pressure system with block-preconditioned "
+                   "FGMRES instead of the projection split");
+    args.AddOption(&steady, "-ss", "--steady", "-no-ss", "--no-steady",
+                   "Solve for the steady state with Newton's method instead of time "
+                   "marching (low Re)");
+    args.AddOption(&steady_tol, "-sstol", "--steady-tol",
+                   "Relative residual reduction at which the steady solve stops");
+    args.AddOption(&steady_max_iter, "-ssit", "--steady-max-iter",
+                   "Maximum number of Newton iterations");
+    args.AddOption(&ensemble_Re, "-ens", "--ensemble-re",
+                   "Comma-separated Reynolds numbers run one after another on the same "
+                   "mesh and operators, each from the previous final state");
+    args.AddOption(&ensemble_dt, "-ensdt", "--ensemble-dt",
+                   "Comma-separated time steps of the -ens cases (one value for all; "
+                   "default -dt)");
+    args.AddOption(&batch, "-batch", "--batch-samples",
+                   "Advance this many samples together with batched CG solves; sample "
+                   "j > 0 has a transverse inlet perturbation");
+    args.AddOption(&batch_amp, "-bamp", "--batch-amplitude",
+                   "Amplitude of the -batch inlet perturbations");
+    args.AddOption(&timing_json, "-json", "--timing-json",
+                   "Write problem size, phase timings and peak memory to this JSON file");
+    args.AddOption(&matvec_bench, "-mvb", "--matvec-bench",
+                   "Time this many applications of the momentum operator H (0 = off)");
 
     args.Parse();
     if (!args.Good())
@@ -46,14 +3091,155 @@ int main(int argc, char *argv[])
         return 1;
     }
     if (Mpi::Root()) args.PrintOptions(cout);
+    count_heap_allocations = count_allocs;
+    if (bdf_order < 1 || bdf_order > max_bdf_order)
+    {
+        if (Mpi::Root()) cout << "Error: -bdf must be 1, 2 or 3" << endl;
+        return 1;
+    }
+    // Ensemble cases; the first one sets up the operators
+    vector<double> case_Re = ParseList(ensemble_Re), case_dt = ParseList(ensemble_dt);
+    const bool ensemble = !case_Re.empty();
+    if (!ensemble) { case_Re.push_back(Re); }
+    if (case_dt.empty()) { case_dt.push_back(dt); }
+    if (case_dt.size() == 1) { case_dt.resize(case_Re.size(), case_dt[0]); }
+    if (case_dt.size() != case_Re.size())
+    {
+        if (Mpi::Root()) cout << "Error: -ensdt needs one value or one per -ens case" << endl;
+        return 1;
+    }
+    if (ensemble && (restart || checkpoint_steps > 0))
+    {
+        if (Mpi::Root()) cout << "Error: -ens does not support checkpoints (-ck, -r)" << endl;
+        return 1;
+    }
+    const int num_cases = (int)case_Re.size();
+    Re = case_Re[0];
+    dt = case_dt[0];
+    const bool batched = (batch > 1);
+    if (batched && (pa || !cache_operators || monolithic || steady || cfl_target > 0.0 ||
+                    ensemble || restart || checkpoint_steps > 0))
+    {
+        if (Mpi::Root())
+        {
+            cout << "Error: -batch needs the projection scheme with a fixed dt and the "
+                 << "assembled, cached operators (no -pa, -no-oc, -mono, -ss, -cfl, -ens, "
+                 << "-ck, -r)" << endl;
+        }
+        return 1;
+    }
+    if ((monolithic || steady) && (pa || !cache_operators))
+    {
+        if (Mpi::Root())
+        {
+            cout << "Error: -mono and -ss need the assembled, cached H and S (-no-pa -oc)"
+                 << endl;
+        }
+        return 1;
+    }
+    if (pres_direct_type != 0 && (pa || !cache_operators))
+    {
+        if (Mpi::Root()) cout << "Error: -pds needs the assembled, cached S (-no-pa -oc)" << endl;
+        return 1;
+    }
+    if (num_threads < 1)
+    {
+        if (Mpi::Root()) cout << "Error: -nt must be at least 1" << endl;
+        return 1;
+    }
+#ifdef _OPENMP
+    omp_set_num_threads(num_threads);
+#ifdef MFEM_USE_OPENMP
+    // PA kernels and device-aware vector operations run on the OpenMP backend
+    Device device(pa && num_threads > 1 ? "omp" : "cpu");
+#endif
+#else
+    if (num_threads > 1)
+    {
+        if (Mpi::Root()) cout << "Built without OpenMP: ignoring -nt" << endl;
+        num_threads = 1;
+    }
+#endif
+    if (num_threads > 1 && mpi_thread_level < MPI_THREAD_FUNNELED && Mpi::Root())
+    {
+        cout << "Warning: the MPI library does not provide MPI_THREAD_FUNNELED" << endl;
+    }
+    if (Mpi::Root())
+    {
+        cout << "Execution: " << Mpi::WorldSize() << " rank(s) x " << num_threads
+             << " thread(s)";
+#ifdef HYPRE_USING_OPENMP
+        cout << ", threaded hypre";
+#else
+        cout << ", hypre without OpenMP";
+#endif
+        cout << endl;
+    }
+    if (pa && grad_mode != 1)
+    {
+        // There is no assembled D to transpose
+        if (Mpi::Root()) cout << "Partial assembly: using -grad 1 (D^T action)" << endl;
+        grad_mode = 1;
+    }
 
     auto start_time = chrono::high_resolution_clock::now();
 
+    Profiler prof(MPI_COMM_WORLD);
+    const int ph_mesh = prof.Register("mesh_load");
+    const int ph_partition = prof.Register("partition");
+    const int ph_asm_M = prof.Register("assemble_M");
+    const int ph_asm_K = prof.Register("assemble_K");
+    const int ph_asm_S = prof.Register("assemble_S");
+    const int ph_asm_D = prof.Register("assemble_D");
+    const int ph_par_M = prof.Register("par_assemble_M");
+    const int ph_par_K = prof.Register("par_assemble_K");
+    const int ph_par_S = prof.Register("par_assemble_S");
+    const int ph_par_D = prof.Register("par_assemble_D");
+    const int ph_form_H = prof.Register("form_H");
+    const int ph_eliminate = prof.Register("eliminate_bc");
+    const int ph_pa_prec = prof.Register("pa_precond_setup");
+    const int ph_convection = prof.Register("convection");
+    const int ph_momentum = prof.Register("momentum_solve", true);
+    const int ph_pressure = prof.Register("pressure_solve", true);
+    const int ph_correction = prof.Register("correction");
+    const int ph_forces = prof.Register("forces");
+    const int ph_output = prof.Register("output");
+    const int ph_fields = prof.Register("field_output");
+    const int ph_checkpoint = prof.Register("checkpoint");
+    const int ph_cfl = prof.Register("cfl");
+    const int ph_pres_factor = prof.Register("pressure_factor");
+    const int ph_monolithic = prof.Register("monolithic_solve", true);
+
     // Load mesh and parallel mesh
-    if (Mpi::Root()) cout << "Loading mesh: " << mesh_file << endl;
-    Mesh *mesh = new Mesh(mesh_file, 1, 1);
-    ParMesh *pmesh = new ParMesh(MPI_COMM_WORLD, *mesh);
-    delete mesh;
+    ParMesh *pmesh = nullptr;
+    if (ogrid)
+    {
+        if (Mpi::Root()) cout << "Generating O-grid mesh" << endl;
+        prof.Start(ph_mesh);
+        pmesh = GenerateOGridMesh(MPI_COMM_WORLD, ogrid_n, ogrid_grading, par_ref, order);
+        prof.Stop(ph_mesh);
+    }
+    else if (mesh_mode == 2)
+    {
+        if (Mpi::Root()) cout << "Loading mesh: " << mesh_file << endl;
+        prof.Start(ph_mesh);
+        pmesh = LoadPartitionedMesh(MPI_COMM_WORLD, mesh_file);
+        prof.Stop(ph_mesh);
+    }
+    else
+    {
+        // Mode 1 reads the serial mesh on rank 0 only
+        if (Mpi::Root()) cout << "Loading mesh: " << mesh_file << endl;
+        prof.Start(ph_mesh);
+        Mesh *mesh = (mesh_mode == 0 || Mpi::Root()) ? new Mesh(mesh_file, 1, 1) : nullptr;
+        prof.Stop(ph_mesh);
+        prof.Start(ph_partition);
+        pmesh = (mesh_mode == 0) ? new ParMesh(MPI_COMM_WORLD, *mesh) :
+                ScatterMesh(MPI_COMM_WORLD, mesh);
+        prof.Stop(ph_partition);
+        delete mesh;
+    }
+    if (*mesh_save_prefix) { SavePartitionedMesh(*pmesh, mesh_save_prefix); }
 
     // FE collections
     H1_FECollection fec_vel(order, pmesh->Dimension());
@@ -86,6 +3272,11 @@ int main(int argc, char *argv[])
     ess_bdr_vel[1] = 1;  // inlet (attr 2)
     ess_bdr_vel[3] = 1;  // walls (attr 4)
 
+    // Of these only the inlet has a nonzero value; cylinder and walls are no-slip
+    Array<int> inlet_bdr(pmesh->bdr_attributes.Max());
+    inlet_bdr = 0;
+    inlet_bdr[1] = 1;
+
     Array<int> ess_bdr_pres(pmesh->bdr_attributes.Max());
     ess_bdr_pres = 0;
     ess_bdr_pres[2] = 1;  // outlet (attr 3) - pressure ref
@@ -96,180 +3287,945 @@ int main(int argc, char *argv[])
     fespace_pres.GetEssentialTrueDofs(ess_bdr_pres, ess_dofs_pres);
 
     // Initialize solution vectors
-    ParGridFunction u(&fespace_vel), u_old(&fespace_vel), u_star(&fespace_vel);
+    ParGridFunction u(&fespace_vel);
     ParGridFunction p(&fespace_pres), p_new(&fespace_pres);
-    ParGridFunction f_conv(&fespace_vel);
 
     u = 0.0;
-    u_old = 0.0;
-    u_star = 0.0;
     p = 0.0;
     p_new = 0.0;
 
-    // Set inlet BC: u = [1, 0]
+    // Set inlet BC: u = [1, 0]; u = 0 stays on the cylinder and the walls
     VectorFunctionCoefficient inlet_coeff(pmesh->Dimension(), [](const Vector &x, Vector &v)
                                           { v(0) = 1.0; v(1) = 0.0; });
-    u.ProjectBdrCoefficient(inlet_coeff, ess_bdr_vel);
-    u_old = u;
+    u.ProjectBdrCoefficient(inlet_coeff, inlet_bdr);
 
-    // Build bilinear forms
-    ParBilinearForm m_form(&fespace_vel);
-    m_form.AddDomainIntegrator(new VectorMassIntegrator());
-    m_form.Assemble();
+    // Build bilinear forms. With -pa only quadrature-point data is stored
+    // and the operators are applied with sum-factorized element kernels;
+    // otherwise the element matrices are computed by all threads.
+    const AssemblyLevel level = pa ? AssemblyLevel::PARTIAL : AssemblyLevel::LEGACY;
+    ThreadedBilinearForm m_form(&fespace_vel, [] { return new VectorMassIntegrator(); });
+    m_form.SetAssemblyLevel(level);
+    prof.Start(ph_asm_M);
+    m_form.AssembleThreaded();
     m_form.Finalize();
+    prof.Stop(ph_asm_M);
 
-    ParBilinearForm k_form(&fespace_vel);
-    k_form.AddDomainIntegrator(new VectorDiffusionIntegrator());
-    k_form.Assemble();
+    ThreadedBilinearForm k_form(&fespace_vel, [] { return new VectorDiffusionIntegrator(); });
+    k_form.SetAssemblyLevel(level);
+    prof.Start(ph_asm_K);
+    k_form.AssembleThreaded();
     k_form.Finalize();
+    prof.Stop(ph_asm_K);
 
-    ParBilinearForm s_form(&fespace_pres);
-    s_form.AddDomainIntegrator(new DiffusionIntegrator());
-    s_form.Assemble();
+    ThreadedBilinearForm s_form(&fespace_pres, [] { return new DiffusionIntegrator(); });
+    s_form.SetAssemblyLevel(level);
+    prof.Start(ph_asm_S);
+    s_form.AssembleThreaded();
     s_form.Finalize();
+    prof.Stop(ph_asm_S);
 
     ParMixedBilinearForm d_form(&fespace_vel, &fespace_pres);
+    d_form.SetAssemblyLevel(level);
     d_form.AddDomainIntegrator(new VectorDivergenceIntegrator());
+    prof.Start(ph_asm_D);
     d_form.Assemble();
     d_form.Finalize();
+    prof.Stop(ph_asm_D);
 
-    // Assemble matrices
-    HypreParMatrix *M = m_form.ParallelAssemble();
-    HypreParMatrix *K = k_form.ParallelAssemble();
-    HypreParMatrix *S = s_form.ParallelAssemble();
-    HypreParMatrix *D = d_form.ParallelAssemble();
+    // Assemble matrices, or wrap the PA forms as true-dof operators
+    HypreParMatrix *M = nullptr, *K = nullptr, *S = nullptr, *D = nullptr;
+    OperatorPtr M_pa, K_pa, D_pa;
+    Array<int> no_dofs;
+    prof.Start(ph_par_M);
+    if (pa) { m_form.FormSystemMatrix(no_dofs, M_pa); }
+    else { M = m_form.ParallelAssemble(); }
+    prof.Stop(ph_par_M);
+    prof.Start(ph_par_K);
+    if (pa) { k_form.FormSystemMatrix(no_dofs, K_pa); }
+    else { K = k_form.ParallelAssemble(); }
+    prof.Stop(ph_par_K);
+    prof.Start(ph_par_S);
+    if (!pa) { S = s_form.ParallelAssemble(); }  // PA: formed with its BCs below
+    prof.Stop(ph_par_S);
+    prof.Start(ph_par_D);
+    if (pa) { d_form.FormRectangularSystemMatrix(no_dofs, no_dofs, D_pa); }
+    else { D = d_form.ParallelAssemble(); }
+    prof.Stop(ph_par_D);
+
+    const Operator *M_op = pa ? M_pa.Ptr() : M;
+    const Operator *K_op = pa ? K_pa.Ptr() : K;
+    const Operator *D_op = pa ? D_pa.Ptr() : D;
 
     // Compute H = M/dt + nu*K using MFEM Add() function
-    // H = (1/dt)*M + nu*K
-    HypreParMatrix *H = Add(1.0/dt, *M, nu, *K);
+    // H = (1/dt)*M + nu*K; with -pa it is its own form with scaled integrators
+    prof.Start(ph_form_H);
+    HypreParMatrix *H = nullptr;
+    ParBilinearForm *h_form = nullptr;
+    ConstantCoefficient h_mass_coeff(1.0 / dt), h_visc_coeff(nu);
+    if (pa)
+    {
+        h_form = new ParBilinearForm(&fespace_vel);
+        h_form->SetAssemblyLevel(AssemblyLevel::PARTIAL);
+        h_form->AddDomainIntegrator(new VectorMassIntegrator(h_mass_coeff));
+        h_form->AddDomainIntegrator(new VectorDiffusionIntegrator(h_visc_coeff));
+        h_form->Assemble();
+    }
+    else
+    {
+        H = Add(1.0/dt, *M, nu, *K);
+    }
+    prof.Stop(ph_form_H);
+
+    // Explicit convection: element kernel, or the nonlinear form as reference
+    ConstantCoefficient one(1.0);
+    ConvectionOperator conv_kernel(fespace_vel, order);
+    ParNonlinearForm conv_nlf(&fespace_vel);
+    conv_nlf.AddDomainIntegrator(new VectorConvectionNLFIntegrator(one));
+    const Operator *conv_op = (conv_mode == 1) ? (const Operator *)&conv_kernel :
+                              (conv_mode == 2) ? (const Operator *)&conv_nlf : nullptr;
+    if (conv_bench > 0) { BenchmarkConvection(fespace_vel, conv_kernel, conv_nlf, conv_bench); }
 
     // Build solvers
+    AMGPreconditioner vel_amg(prof, "vel"), pres_amg(prof, "pres");
+
     CGSolver vel_solver(MPI_COMM_WORLD);
-    vel_solver.SetPreconditioner(*new HypreBoomerAMG(*H));
+    vel_solver.SetPreconditioner(vel_amg);
     vel_solver.SetMaxIter(200);
     vel_solver.SetRelTol(1e-8);
     vel_solver.SetAbsTol(1e-10);
 
     CGSolver pres_solver(MPI_COMM_WORLD);
-    pres_solver.SetPreconditioner(*new HypreBoomerAMG(*S));
+    pres_solver.SetPreconditioner(pres_amg);
     pres_solver.SetMaxIter(200);
     pres_solver.SetRelTol(1e-8);
     pres_solver.SetAbsTol(1e-10);
 
+    // With a fixed mesh and dt, H and S never change: eliminate once here
+    // and build the AMG hierarchies on the eliminated operators
+    EliminatedOperator *H_elim = nullptr;
+    EliminatedOperator *S_elim = nullptr;
+    OperatorPtr H_pa, S_pa;
+    PAPreconditioner *vel_pa_prec = nullptr, *pres_pa_prec = nullptr;
+    DirectSolver *pres_direct = nullptr;
+    if (pa)
+    {
+        // FormSystemMatrix wraps the PA forms in ConstrainedOperators, which
+        // play the role of the eliminated matrices
+        prof.Start(ph_eliminate);
+        h_form->FormSystemMatrix(ess_dofs_vel, H_pa);
+        s_form.FormSystemMatrix(ess_dofs_pres, S_pa);
+        prof.Stop(ph_eliminate);
+        prof.Start(ph_pa_prec);
+        vel_pa_prec = new PAPreconditioner(pa_prec, *h_form, *H_pa, ess_dofs_vel,
+                                           vel_amg, 1.0 / dt, nu);
+        pres_pa_prec = new PAPreconditioner(pa_prec, s_form, *S_pa, ess_dofs_pres,
+                                            pres_amg, 0.0, 0.0);
+        prof.Stop(ph_pa_prec);
+        vel_solver.SetPreconditioner(*vel_pa_prec);
+        pres_solver.SetPreconditioner(*pres_pa_prec);
+        vel_solver.SetOperator(*H_pa);
+        pres_solver.SetOperator(*S_pa);
+    }
+    else if (cache_operators)
+    {
+        prof.Start(ph_eliminate);
+        H_elim = new EliminatedOperator(*H, ess_dofs_vel);
+        S_elim = new EliminatedOperator(*S, ess_dofs_pres);
+        prof.Stop(ph_eliminate);
+        vel_amg.Update(H_elim->Get(), 1.0 / dt, nu, pmesh->GetSequence());
+        vel_solver.SetOperator(H_elim->Get());
+        if (pres_direct_type != 0)
+        {
+            // S is independent of dt and nu: one factorization for the run
+            prof.Start(ph_pres_factor);
+            pres_direct = new DirectSolver(pres_direct_type, S_elim->Get());
+            prof.Stop(ph_pres_factor);
+        }
+        else
+        {
+            // S is independent of dt and nu
+            pres_amg.Update(S_elim->Get(), 0.0, 0.0, pmesh->GetSequence());
+            pres_solver.SetOperator(S_elim->Get());
+        }
+    }
+
+    // Coupled solve: the Schur complement approximation also needs the
+    // pressure mass matrix
+    MonolithicSolver *mono = nullptr;
+    SteadySolver *steady_solver = nullptr;
+    HypreParMatrix *Mp = nullptr;
+    if (monolithic || steady)
+    {
+        ParBilinearForm mp_form(&fespace_pres);
+        mp_form.AddDomainIntegrator(new MassIntegrator());
+        mp_form.Assemble();
+        mp_form.Finalize();
+        Mp = mp_form.ParallelAssemble();
+        Solver &L_inv = pres_direct ? (Solver &)*pres_direct : (Solver &)pres_amg;
+        if (monolithic)
+        {
+            mono = new MonolithicSolver(*D, ess_dofs_vel, H_elim->Get(), 1.0 / dt, nu,
+                                        vel_amg, L_inv, *Mp, MPI_COMM_WORLD);
+        }
+        if (steady)
+        {
+            // Newton on the consistent convection form, whose gradient is the
+            // exact Jacobian of the residual
+            steady_solver = new SteadySolver(prof, *K, *D, conv_nlf, nu, ess_dofs_vel, L_inv,
+                                             *Mp, pmesh->GetSequence());
+            steady_solver->SetTolerances(steady_tol, 1e-10, steady_max_iter);
+        }
+    }
+
+    if (matvec_bench > 0)
+    {
+        const Operator &H_op = pa ? *H_pa : (cache_operators ? H_elim->Get() : *H);
+        BenchmarkMatVec(H_op, MPI_COMM_WORLD, fespace_vel.GlobalTrueVSize(), matvec_bench);
+        if (batched)
+        {
+            BenchmarkBatchedMatVec(H_elim->Get(), MPI_COMM_WORLD,
+                                   fespace_vel.GlobalTrueVSize(), matvec_bench, batch);
+        }
+    }
+
+    // Initial guesses for the two solves; the velocity projection basis is
+    // only valid for the H it was built with
+    InitialGuess vel_guess(guess_type, fespace_vel.GetTrueVSize(), guess_depth, MPI_COMM_WORLD);
+    InitialGuess pres_guess(guess_type, fespace_pres.GetTrueVSize(), guess_depth,
+                            MPI_COMM_WORLD);
+    vel_solver.iterative_mode = vel_guess.Enabled();
+    pres_solver.iterative_mode = pres_guess.Enabled();
+
+    // Rebuild H = alpha M + nu K with its eliminated form and preconditioner.
+    // alpha = b0/dt changes while the BDF history fills up and, with -cfl,
+    // whenever dt changes. H is recombined from the cached M and K; the
+    // velocity preconditioner is only rebuilt once alpha has drifted by more
+    // than -prt from the value it was set up for (prec_alpha), and lags
+    // behind until then.
+    const bool adaptive_dt = (cfl_target > 0.0);
+    if (adaptive_dt && cache_operators && !pa) { vel_amg.SetRebuildTolerance(prec_rebuild_tol); }
+    double h_alpha = 1.0 / dt, prec_alpha = h_alpha;
+    int h_refreshes = 0;
+    auto form_momentum_operator = [&](double alpha)
+    {
+        h_alpha = alpha;
+        h_refreshes++;
+        if (pa)
+        {
+            prof.Start(ph_form_H);
+            h_mass_coeff.constant = alpha;
+            h_visc_coeff.constant = nu;
+            h_form->Assemble();  // H_pa wraps h_form and sees the new data
+            prof.Stop(ph_form_H);
+            // Chebyshev's diagonal and eigenvalue bound belong to the old H_pa
+            // and may no longer enclose its spectrum, so it is always rebuilt
+            if (adaptive_dt && pa_prec != PAPreconditioner::CHEBYSHEV &&
+                fabs(alpha - prec_alpha) <= prec_rebuild_tol * prec_alpha)
+            {
+                return;
+            }
+            prec_alpha = alpha;
+            prof.Start(ph_pa_prec);
+            delete vel_pa_prec;
+            vel_pa_prec = new PAPreconditioner(pa_prec, *h_form, *H_pa, ess_dofs_vel,
+                                               vel_amg, alpha, nu);
+            prof.Stop(ph_pa_prec);
+            vel_solver.SetPreconditioner(*vel_pa_prec);
+            vel_solver.SetOperator(*H_pa);
+            return;
+        }
+        prof.Start(ph_form_H);
+        delete H;
+        H = Add(alpha, *M, nu, *K);
+        prof.Stop(ph_form_H);
+        if (cache_operators)
+        {
+            prof.Start(ph_eliminate);
+            delete H_elim;
+            H_elim = new EliminatedOperator(*H, ess_dofs_vel);
+            prof.Stop(ph_eliminate);
+            if (vel_amg.Update(H_elim->Get(), alpha, nu, pmesh->GetSequence()))
+            {
+                prec_alpha = alpha;
+            }
+            vel_solver.SetOperator(H_elim->Get());
+            if (mono) { mono->SetMomentumOperator(H_elim->Get(), alpha, nu); }
+        }
+    };
+
+    // Discrete gradient G = D^T, assembled once and held for the whole run
+    HypreParMatrix *G = (grad_mode == 0) ? D->Transpose() : nullptr;
+
+    // Persistent true-dof storage for the loop
+    TimeStepWorkspace ws(fespace_vel, fespace_pres);
+    u.GetTrueDofs(ws.U_star);  // Dirichlet values (inlet) for the predictor
+    p_new.GetTrueDofs(ws.P_new);
+    MassInverse mass_inv(mass_inv_type, *M_op, MPI_COMM_WORLD);
+
+    // Batched samples (-batch): sample 0 is the main state, sample j > 0
+    // differs by the transverse inlet velocity amp sin(j pi (y - y0) / Ly).
+    // They share dt and nu, hence H and S, and their solves run as one
+    // batched CG that streams the matrix entries once for all samples.
+    vector<TimeStepWorkspace *> samples;
+    BatchedMatrix M_batch, D_batch, G_batch;
+    BatchedCG *vel_bcg = nullptr, *pres_bcg = nullptr;
+    Array<Vector *> batch_in(batch), batch_out(batch);
+    if (batched)
+    {
+        Vector bb_min, bb_max;
+        pmesh->GetBoundingBox(bb_min, bb_max);
+        double y0 = bb_min(1), y1 = bb_max(1);
+        MPI_Allreduce(MPI_IN_PLACE, &y0, 1, MPI_DOUBLE, MPI_MIN, MPI_COMM_WORLD);
+        MPI_Allreduce(MPI_IN_PLACE, &y1, 1, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD);
+
+        u.GetTrueDofs(ws.U);
+        samples.push_back(&ws);
+        ParGridFunction u_j(&fespace_vel);
+        for (int j = 1; j < batch; j++)
+        {
+            VectorFunctionCoefficient inlet_j(2, [=](const Vector &x, Vector &v)
+            {
+                v(0) = 1.0;
+                v(1) = batch_amp * sin(j * M_PI * (x(1) - y0) / (y1 - y0));
+            });
+            u_j = u;
+            u_j.ProjectBdrCoefficient(inlet_j, inlet_bdr);
+            TimeStepWorkspace *w = new TimeStepWorkspace(fespace_vel, fespace_pres);
+            u_j.GetTrueDofs(w->U_star);
+            u_j.GetTrueDofs(w->U);
+            w->P_new = 0.0;
+            samples.push_back(w);
+        }
+
+        M_batch.Bind(*M, batch);
+        D_batch.Bind(*D, batch);
+        if (G) { G_batch.Bind(*G, batch); }
+        vel_bcg = new BatchedCG(MPI_COMM_WORLD, batch, fespace_vel.GetTrueVSize());
+        vel_bcg->SetPreconditioner(vel_amg);
+        pres_bcg = new BatchedCG(MPI_COMM_WORLD, batch, fespace_pres.GetTrueVSize());
+        pres_bcg->SetPreconditioner(pres_amg);
+        pres_bcg->SetOperator(S_elim->Get());
+    }
+
     // Time integration
     double t = 0.0;
     int step = 0;
     int out_step = 0;
 
-    ofstream force_file("forces_simple.dat");
-    force_file << "time\tDrag\tLift\n";
+    // BDFk/EXTk: step sizes of the history (dt_hist[0] is the current step).
+    // With k > 1 the pressure is solved in incremental form: the predictor
+    // carries D^T p^n and the Poisson solve yields p^{n+1} - p^n, which keeps
+    // the splitting error second order.
+    double dt_hist[max_bdf_order] = {dt, dt, dt};
+    CFLEstimator cfl_estimator(fespace_vel, order);
+    TimeStepController dt_control(cfl_target, dt_growth, dt_max);
+    double cfl = 0.0, dt_lo = dt, dt_hi = dt;
+    double bdf[max_bdf_order + 1], ext[max_bdf_order + 1];
+    const bool incremental = (bdf_order > 1 && !mono);
 
-    if (Mpi::Root()) cout << "\nStarting time integration..." << endl;
+    // The first steps size the Krylov and hypre wrapper vectors and rebuild
+    // H while the BDF order ramps up; after that the loop must not touch the
+    // heap
+    const int alloc_warmup_steps = bdf_order + 1;
+    long allocs_at_warmup = 0;
 
-    while (t < t_final)
+    // Checkpointed state: everything the next step reads besides the operators
+    Checkpoint checkpoint(MPI_COMM_WORLD, checkpoint_dir, checkpoint_keep,
+                          fespace_vel, fespace_pres);
+    checkpoint.Register(ws.U, true);
+    checkpoint.Register(ws.U_star, true);
+    for (int j = 0; j < max_bdf_order; j++)
     {
-        // Store old solution
-        u_old = u;
-
-        // Step 1: Momentum predictor - solve (H) u* = (M/dt) u_old - f_conv
+        checkpoint.Register(ws.U_hist[j], true);
+        checkpoint.Register(ws.N_hist[j], true);
+    }
+    checkpoint.Register(ws.P, false);
+    checkpoint.Register(ws.P_new, false);
+    // Krylov guess histories, and the alphas of H and of its (lagging)
+    // preconditioner, which both affect the next solves
+    for (Vector &x : vel_guess.History()) { checkpoint.Register(x, true); }
+    for (Vector &x : pres_guess.History()) { checkpoint.Register(x, false); }
+    checkpoint.Register(vel_guess.Count());
+    checkpoint.Register(pres_guess.Count());
+    checkpoint.Register(h_alpha);
+    checkpoint.Register(prec_alpha);
+    if (restart)
+    {
+        if (checkpoint.Load(step, t, dt_hist, bdf_order))
+        {
+            if (adaptive_dt) { dt = dt_hist[0]; }
+            // Rebuild the preconditioner for the alpha it was set up for, then
+            // H for its own alpha, so both match the run that wrote the
+            // checkpoint; the restored velocity guesses belong to this H
+            const double alpha = h_alpha, setup_alpha = prec_alpha;
+            vel_amg.Clear();
+            prec_alpha = 0.0;
+            form_momentum_operator(setup_alpha);
+            if (alpha != setup_alpha) { form_momentum_operator(alpha); }
+            u.Distribute(ws.U);
+            p.Distribute(ws.P);
+            p_new.Distribute(ws.P_new);
+        }
+        else if (Mpi::Root())
         {
-            // Create HypreParVectors from grid functions
-            HypreParVector *U_old = u_old.ParallelProject();
-            HypreParVector *U_star = u_star.ParallelProject();
-            HypreParVector RHS(fespace_vel.GetComm(), fespace_vel.GlobalTrueVSize(),
-                               fespace_vel.GetTrueDofOffsets());
+            cout << "No checkpoint in " << checkpoint_dir << ", starting from t = 0" << endl;
+        }
+    }
+    int first_step = step;
+
+    if (*profile_csv) { prof.OpenStepCSV(profile_csv); }
+
+    SurfaceForces surface_forces(fespace_vel, fespace_pres, 1, order);
+    VolumeForces volume_forces(fespace_vel, *M_op, *K_op, *D_op, 1);
 
-            // Compute RHS = (M/dt) * u_old
-            M->Mult(*U_old, RHS);
-            RHS *= (1.0 / dt);
+    // Field snapshots: every rank writes its own .vtu piece, rank 0 only adds
+    // the small .pvtu/.pvd index files, so the I/O does not funnel through
+    // one process
+    ParaViewDataCollection *pv = nullptr;
+    VorticityField *vorticity = (pv_steps > 0) ? new VorticityField(*pmesh, order) : nullptr;
+
+    // Ensemble (-ens): the cases run one after another on the same mesh and
+    // assembled M, K, S and D; only H = (b0/dt) M + nu K and its
+    // preconditioner are rebuilt. Each case starts from the final state of
+    // the previous one and writes its own force history.
+    int total_steps = 0, alloc_steps = 0;
+    long loop_allocs = 0;
+    const double loop_start = MPI_Wtime();
+    for (int c = 0; c < num_cases; c++)
+    {
+        if (c > 0)
+        {
+            Re = case_Re[c];
+            nu = 1.0 / Re;
+            dt = case_dt[c];
+            t = 0.0;
+            step = first_step = 0;
+            for (int j = 0; j < max_bdf_order; j++) { dt_hist[j] = dt; }
+            dt_lo = dt_hi = dt;
+            h_alpha = prec_alpha = 0.0;  // H is rebuilt in the first step
+            vel_guess.Reset();
+            pres_guess.Reset();
+            if (steady_solver) { steady_solver->SetViscosity(nu); }
+        }
+        ostringstream case_id;
+        case_id << "Re" << Re << "_dt" << dt;
+        const string case_name = case_id.str();
+        if (ensemble && Mpi::Root())
+        {
+            cout << "\nCase " << c + 1 << "/" << num_cases << ": Re = " << Re << ", dt = "
+                 << dt << endl;
+        }
 
-            // Apply Dirichlet BCs
-            HypreParMatrix H_copy(*H);
-            H_copy.EliminateRowsCols(ess_dofs_vel, *U_star, RHS);
+        const string force_filename =
+            (ensemble ? "forces_" + case_name : string("forces_simple")) +
+            (force_format == TimeSeriesWriter::BINARY ? ".bin" : ".dat");
+        TimeSeriesWriter *force_file =
+            new TimeSeriesWriter(MPI_COMM_WORLD, force_filename, {"time", "Drag", "Lift"},
+                                 force_format, force_buffer, force_async, restart,
+                                 t - 0.5 * dt_hist[0]);
+        vector<TimeSeriesWriter *> force_files = {force_file};
+        for (int j = 1; j < (int)samples.size(); j++)
+        {
+            const string name = "forces_sample" + to_string(j) +
+                                (force_format == TimeSeriesWriter::BINARY ? ".bin" : ".dat");
+            force_files.push_back(new TimeSeriesWriter(MPI_COMM_WORLD, name,
+                                                       {"time", "Drag", "Lift"}, force_format,
+                                                       force_buffer, force_async));
+        }
 
-            // Solve
-            vel_solver.SetOperator(H_copy);
-            vel_solver.Mult(RHS, *U_star);
+        if (pv_steps > 0)
+        {
+            delete pv;
+            pv = new ParaViewDataCollection("cylinder", pmesh);
+            pv->SetPrefixPath(ensemble ? "ParaView/" + case_name : string("ParaView"));
+            pv->SetLevelsOfDetail(order);
+            pv->SetHighOrderOutput(true);
+            pv->SetDataFormat(pv_float32 ? VTKFormat::BINARY32 : VTKFormat::BINARY);
+            pv->SetCompressionLevel(pv_compress);
+            pv->RegisterField("velocity", &u);
+            pv->RegisterField("pressure", &p);
+            pv->RegisterField("vorticity", &vorticity->Get());
+        }
 
-            // Update grid function
-            u_star.Distribute(U_star);
+        // Steady mode: the time loop below is skipped
+        if (steady)
+        {
+            if (Mpi::Root()) cout << "\nSolving for the steady state..." << endl;
+            u.GetTrueDofs(ws.U);
+            p.GetTrueDofs(ws.P);
+            const bool converged = steady_solver->Solve(ws.U, ws.P);
+            u.Distribute(ws.U);
+            p.Distribute(ws.P);
 
-            delete U_old;
-            delete U_star;
+            double F[2];
+            surface_forces.Compute(u, p, nu, F);
+            const double record[3] = {0.0, 2.0 * F[0], 2.0 * F[1]};
+            force_file->Append(record);
+            if (pv)
+            {
+                vorticity->Update(u);
+                pv->SetCycle(0);
+                pv->SetTime(0.0);
+                pv->Save();
+            }
+            if (Mpi::Root())
+            {
+                cout << (converged ? "Converged" : "Not converged") << " after "
+                     << steady_solver->Iterations() << " Newton iterations ("
+                     << steady_solver->LinearIterations() << " FGMRES iterations), Cd = "
+                     << record[1] << ", Cl = " << record[2] << endl;
+            }
         }
+        else if (Mpi::Root()) { cout << "\nStarting time integration..." << endl; }
 
-        // Step 2: Pressure Poisson - solve S p = (1/dt) D·u*
+        // Batched samples: the same steps as the loop below, for all samples
+        while (batched && t < t_final)
         {
-            // Create HypreParVectors
-            HypreParVector *U_star = u_star.ParallelProject();
-            HypreParVector *P_new = p_new.ParallelProject();
-            HypreParVector RHS_p(fespace_pres.GetComm(), fespace_pres.GlobalTrueVSize(),
-                                 fespace_pres.GetTrueDofOffsets());
+            if (step == first_step + alloc_warmup_steps)
+            {
+                allocs_at_warmup = heap_allocations.load();
+            }
+            prof.BeginStep();
+
+            for (int j = max_bdf_order - 1; j > 0; j--) { dt_hist[j] = dt_hist[j - 1]; }
+            dt_hist[0] = dt;
+            const int k = min(bdf_order, step + 1);
+            BDFCoefficients(k, dt_hist, bdf, ext);
+            if (bdf[0] / dt != h_alpha)
+            {
+                form_momentum_operator(bdf[0] / dt);
+                vel_guess.OperatorChanged();
+            }
+
+            const Vector *hist[max_bdf_order];
+            for (TimeStepWorkspace *w : samples)
+            {
+                w->ShiftHistory();
+                w->U_hist[0] = w->U;
+            }
+
+            if (conv_op)
+            {
+                ScopedPhase timer(prof, ph_convection);
+                for (TimeStepWorkspace *w : samples)
+                {
+                    conv_op->Mult(w->U_hist[0], w->N_hist[0]);
+                    for (int j = 0; j < max_bdf_order; j++) { hist[j] = &w->N_hist[j]; }
+                    LinearCombination(k, ext + 1, hist, w->N);
+                }
+            }
+
+            // Step 1: Momentum predictor for all samples
+            {
+                ScopedPhase timer(prof, ph_momentum);
+                for (int s = 0; s < batch; s++)
+                {
+                    TimeStepWorkspace *w = samples[s];
+                    for (int j = 0; j < max_bdf_order; j++) { hist[j] = &w->U_hist[j]; }
+                    LinearCombination(k, bdf + 1, hist, w->U_bdf);
+                    batch_in[s] = &w->U_bdf;
+                    batch_out[s] = &w->RHS_u;
+                }
+                M_batch.Mult(batch, batch_in, batch_out);
+                for (int s = 0; s < batch; s++)
+                {
+                    TimeStepWorkspace *w = samples[s];
+                    if (conv_op) { Axpby(-1.0, w->N, 1.0 / dt, w->RHS_u); }
+                    else { w->RHS_u *= (1.0 / dt); }
+                    if (incremental) { D->AddMultTranspose(w->P, w->RHS_u); }
+                    H_elim->EliminateRHS(w->U_star, w->RHS_u);
+                    batch_in[s] = &w->RHS_u;
+                    batch_out[s] = &w->U_star;
+                }
+                vel_bcg->SetOperator(H_elim->Get());
+                vel_bcg->Mult(batch_in, batch_out);
+                prof.RecordSolve(ph_momentum, vel_bcg->MaxIterations(),
+                                 vel_bcg->MaxFinalNorm());
+            }
+
+            // Step 2: Pressure Poisson for all samples
+            {
+                ScopedPhase timer(prof, ph_pressure);
+                for (int s = 0; s < batch; s++)
+                {
+                    batch_in[s] = &samples[s]->U_star;
+                    batch_out[s] = &samples[s]->RHS_p;
+                }
+                D_batch.Mult(batch, batch_in, batch_out);
+                for (int s = 0; s < batch; s++)
+                {
+                    TimeStepWorkspace *w = samples[s];
+                    w->RHS_p *= (-bdf[0] / dt);
+                    S_elim->EliminateRHS(w->P_new, w->RHS_p);
+                    if (pres_direct) { pres_direct->Mult(w->RHS_p, w->P_new); }
+                    batch_in[s] = &w->RHS_p;
+                    batch_out[s] = &w->P_new;
+                }
+                if (!pres_direct)
+                {
+                    pres_bcg->Mult(batch_in, batch_out);
+                    prof.RecordSolve(ph_pressure, pres_bcg->MaxIterations(),
+                                     pres_bcg->MaxFinalNorm());
+                }
+            }
 
-            // Compute RHS = (1/dt) * D * u_star
-            D->Mult(*U_star, RHS_p);
-            RHS_p *= (1.0 / dt);
+            // Step 3: Velocity correction and pressure update for all samples
+            {
+                ScopedPhase timer(prof, ph_correction);
+                for (int s = 0; s < batch; s++)
+                {
+                    batch_in[s] = &samples[s]->P_new;
+                    batch_out[s] = &samples[s]->Gp;
+                }
+                if (G) { G_batch.Mult(batch, batch_in, batch_out); }
+                for (TimeStepWorkspace *w : samples)
+                {
+                    if (!G) { D->MultTranspose(w->P_new, w->Gp); }
+                    mass_inv.Mult(w->Gp, w->dU);
+                    w->dU.SetSubVector(ess_dofs_vel, 0.0);
+                    const double c[2] = {1.0, dt / bdf[0]};
+                    const Vector *x[2] = {&w->U_star, &w->dU};
+                    LinearCombination(2, c, x, w->U);
+                    if (incremental) { w->P += w->P_new; }
+                    else { w->P = w->P_new; }
+                }
+            }
 
-            // Apply Dirichlet BC for pressure
-            HypreParMatrix S_copy(*S);
-            S_copy.EliminateRowsCols(ess_dofs_pres, *P_new, RHS_p);
+            // Forces of every sample into its own file
+            if (step % vis_steps == 0)
+            {
+                for (int s = 0; s < batch; s++)
+                {
+                    TimeStepWorkspace *w = samples[s];
+                    prof.Start(ph_forces);
+                    double F[2];
+                    if (force_method == 0)
+                    {
+                        u.Distribute(w->U);
+                        p.Distribute(w->P);
+                        surface_forces.Compute(u, p, nu, F);
+                    }
+                    else
+                    {
+                        volume_forces.Compute(w->U, w->U_bdf, bdf[0], w->P,
+                                              conv_op ? &w->N : nullptr, dt, nu, F);
+                    }
+                    prof.Stop(ph_forces);
 
-            // Solve
-            pres_solver.SetOperator(S_copy);
-            pres_solver.Mult(RHS_p, *P_new);
+                    ScopedPhase timer(prof, ph_output);
+                    const double record[3] = {t, 2.0 * F[0], 2.0 * F[1]};
+                    if (s == 0 && Mpi::Root())
+                    {
+                        cout << "Step " << step << ", t = " << t << ", Cd = " << record[1]
+                             << ", Cl = " << record[2] << " (sample 0 of " << batch << ")"
+                             << endl;
+                    }
+                    force_files[s]->Append(record);
+                }
+            }
 
-            // Update grid function
-            p_new.Distribute(P_new);
+            if (pv && step % pv_steps == 0)
+            {
+                ScopedPhase timer(prof, ph_fields);
+                u.Distribute(ws.U);
+                p.Distribute(ws.P);
+                vorticity->Update(u);
+                pv->SetCycle(step);
+                pv->SetTime(t);
+                pv->Save();
+            }
 
-            delete U_star;
-            delete P_new;
+            prof.EndStep(step, t);
+            t += dt;
+            step++;
+        }
+        if (batched)
+        {
+            u.Distribute(ws.U);
+            p.Distribute(ws.P);
         }
 
-        // Step 3: Velocity correction - u = u* - dt * G * p
+        while (!batched && !steady && t < t_final)
         {
-            HypreParMatrix *DT = D->Transpose();
-            Vector p_new_vec(p_new.GetData(), pres_size);
-            Vector Gp(vel_size);
-            DT->Mult(p_new_vec, Gp);
-            Gp *= dt;
+            if (step == first_step + alloc_warmup_steps)
+            {
+                allocs_at_warmup = heap_allocations.load();
+            }
+            prof.BeginStep();
+
+            // Step size from the CFL number of u^n; dt_hist[0] is this step
+            if (adaptive_dt)
+            {
+                ScopedPhase timer(prof, ph_cfl);
+                const double rate = cfl_estimator.MaxRate(u);
+                dt = dt_control.Next(dt, rate);
+                cfl = rate * dt;
+                dt_lo = min(dt_lo, dt);
+                dt_hi = max(dt_hi, dt);
+            }
+            for (int j = max_bdf_order - 1; j > 0; j--) { dt_hist[j] = dt_hist[j - 1]; }
+            dt_hist[0] = dt;
 
-            Vector u_star_vec(u_star.GetData(), vel_size);
-            Vector u_vec(u.GetData(), vel_size);
-            u_vec = u_star_vec;
-            u_vec -= Gp;
+            // The order ramps up to bdf_order as the history fills; H follows b0/dt
+            const int k = min(bdf_order, step + 1);
+            BDFCoefficients(k, dt_hist, bdf, ext);
+            if (bdf[0] / dt != h_alpha)
+            {
+                form_momentum_operator(bdf[0] / dt);
+                vel_guess.OperatorChanged();
+            }
 
-            u = u_vec;
-            delete DT;
-        }
+            // Store old solution: history slot 0 becomes u^n
+            ws.ShiftHistory();
+            u.GetTrueDofs(ws.U_hist[0]);
+            const Vector *u_hist[max_bdf_order], *n_hist[max_bdf_order];
+            for (int j = 0; j < max_bdf_order; j++)
+            {
+                u_hist[j] = &ws.U_hist[j];
+                n_hist[j] = &ws.N_hist[j];
+            }
 
-        // Update pressure
-        p = p_new;
+            // Explicit convection N(u^n) = ((u^n . grad) u^n, v), extrapolated
+            // to t^{n+1}: N* = sum_j e_j N(u^{n+1-j})
+            if (conv_op)
+            {
+                ScopedPhase timer(prof, ph_convection);
+                conv_op->Mult(ws.U_hist[0], ws.N_hist[0]);
+                LinearCombination(k, ext + 1, n_hist, ws.N);
+            }
 
-        // Simple drag/lift calculation
-        double Cd = 2.0 * (p(0) - p(pres_size - 1)) / (1.0 * 1.0);
-        double Cl = 0.1 * sin(2.0 * M_PI * t);
+            // Monolithic mode: u^{n+1} and p^{n+1} from the coupled system with
+            // the same right-hand side as the predictor; replaces steps 1-3
+            if (mono)
+            {
+                ScopedPhase timer(prof, ph_monolithic);
+                LinearCombination(k, bdf + 1, u_hist, ws.U_bdf);
+                M_op->Mult(ws.U_bdf, ws.RHS_u);
+                if (conv_op) { Axpby(-1.0, ws.N, 1.0 / dt, ws.RHS_u); }
+                else { ws.RHS_u *= (1.0 / dt); }
+                H_elim->EliminateRHS(ws.U_star, ws.RHS_u);
+                mono->Mult(ws.RHS_u, ws.U_star, ws.U, ws.P_new);
+                prof.RecordSolve(ph_monolithic, mono->Krylov());
+                ws.U_star.Set(1.0, ws.U);  // velocity guess of the next step
+                u.Distribute(ws.U);
+                p_new.Distribute(ws.P_new);
+            }
 
-        // Output
-        if (step % vis_steps == 0)
-        {
-            if (Mpi::Root())
+            // Step 1: Momentum predictor - solve (H) u* = (M/dt) sum_j b_j u^{n+1-j} - N*
+            // (+ D^T p^n in incremental form), H = (b0/dt) M + nu K
+            if (!mono)
             {
-                cout << "Step " << step << ", t = " << t << ", Cd = " << Cd << ", Cl = " << Cl
-                     << endl;
+                ScopedPhase timer(prof, ph_momentum);
+
+                // Compute RHS = (M/dt) * U_bdf - N*
+                LinearCombination(k, bdf + 1, u_hist, ws.U_bdf);
+                M_op->Mult(ws.U_bdf, ws.RHS_u);
+                if (conv_op) { Axpby(-1.0, ws.N, 1.0 / dt, ws.RHS_u); }
+                else { ws.RHS_u *= (1.0 / dt); }
+                if (incremental) { D_op->AddMultTranspose(ws.P, ws.RHS_u); }
+
+                // Apply Dirichlet BCs, seed the initial guess and solve
+                HypreParMatrix *H_copy = nullptr;
+                if (pa)
+                {
+                    H_pa.As<ConstrainedOperator>()->EliminateRHS(ws.U_star, ws.RHS_u);
+                }
+                else if (cache_operators)
+                {
+                    H_elim->EliminateRHS(ws.U_star, ws.RHS_u);
+                }
+                else
+                {
+                    H_copy = new HypreParMatrix(*H);
+                    H_copy->EliminateRowsCols(ess_dofs_vel, ws.U_star, ws.RHS_u);
+                    vel_amg.Clear();
+                    vel_solver.SetOperator(*H_copy);
+                }
+                const Operator &H_sys = pa ? *H_pa : (H_copy ? *H_copy : H_elim->Get());
+                vel_guess.Predict(dt_hist, ws.RHS_u, ws.U_star, ess_dofs_vel);
+                vel_solver.Mult(ws.RHS_u, ws.U_star);
+                vel_guess.Store(H_sys, ws.U_star);
+                if (H_copy)
+                {
+                    vel_amg.Clear();
+                    delete H_copy;
+                }
+                prof.RecordSolve(ph_momentum, vel_solver);
             }
-            if (Mpi::Root())
+
+            // Step 2: Pressure Poisson - solve S p = -(b0/dt) D·u*
+            // (D^T p = -(grad p, v), so this sign gives the physical pressure;
+            // in incremental form p_new is the increment p^{n+1} - p^n)
+            if (!mono)
+            {
+                ScopedPhase timer(prof, ph_pressure);
+
+                // Compute RHS = -(b0/dt) * D * u_star
+                D_op->Mult(ws.U_star, ws.RHS_p);
+                ws.RHS_p *= (-bdf[0] / dt);
+
+                // Apply Dirichlet BC for pressure, seed the initial guess and solve
+                HypreParMatrix *S_copy = nullptr;
+                if (pa)
+                {
+                    S_pa.As<ConstrainedOperator>()->EliminateRHS(ws.P_new, ws.RHS_p);
+                }
+                else if (cache_operators)
+                {
+                    S_elim->EliminateRHS(ws.P_new, ws.RHS_p);
+                }
+                else
+                {
+                    S_copy = new HypreParMatrix(*S);
+                    S_copy->EliminateRowsCols(ess_dofs_pres, ws.P_new, ws.RHS_p);
+                    pres_amg.Clear();
+                    pres_solver.SetOperator(*S_copy);
+                }
+                const Operator &S_sys = pa ? *S_pa : (S_copy ? *S_copy : S_elim->Get());
+                if (pres_direct)
+                {
+                    pres_direct->Mult(ws.RHS_p, ws.P_new);
+                }
+                else
+                {
+                    pres_guess.Predict(dt_hist, ws.RHS_p, ws.P_new, ess_dofs_pres);
+                    pres_solver.Mult(ws.RHS_p, ws.P_new);
+                    pres_guess.Store(S_sys, ws.P_new);
+                    prof.RecordSolve(ph_pressure, pres_solver);
+                }
+                if (S_copy)
+                {
+                    pres_amg.Clear();
+                    delete S_copy;
+                }
+
+                // Update grid function
+                p_new.Distribute(ws.P_new);
+            }
+
+            // Step 3: Velocity correction - u = u* + (dt/b0) * M^{-1} G * p
+            // on true dofs; Dirichlet dofs keep the values of u*
+            if (!mono)
+            {
+                ScopedPhase timer(prof, ph_correction);
+                if (grad_mode == 0)
+                {
+                    G->Mult(ws.P_new, ws.Gp);
+                }
+                else if (grad_mode == 1)
+                {
+                    D_op->MultTranspose(ws.P_new, ws.Gp);
+                }
+                else
+                {
+                    HypreParMatrix *DT = D->Transpose();
+                    DT->Mult(ws.P_new, ws.Gp);
+                    delete DT;
+                }
+                mass_inv.Mult(ws.Gp, ws.dU);
+                ws.dU.SetSubVector(ess_dofs_vel, 0.0);
+                const double c[2] = {1.0, dt / bdf[0]};
+                const Vector *x[2] = {&ws.U_star, &ws.dU};
+                LinearCombination(2, c, x, ws.U);
+
+                u.Distribute(ws.U);
+            }
+
+            // Update pressure
+            if (incremental) { p += p_new; }
+            else { p = p_new; }
+            p.GetTrueDofs(ws.P);
+
+            // Output
+            if (step % vis_steps == 0)
+            {
+                // Drag/lift coefficients from the cylinder traction (U = 1, D = 1)
+                prof.Start(ph_forces);
+                double F[2];
+                if (force_method == 0)
+                {
+                    surface_forces.Compute(u, p, nu, F);
+                }
+                else
+                {
+                    volume_forces.Compute(ws.U, ws.U_bdf, bdf[0], ws.P,
+                                          conv_op ? &ws.N : nullptr, dt, nu, F);
+                }
+                double Cd = 2.0 * F[0] / (1.0 * 1.0);
+                double Cl = 2.0 * F[1] / (1.0 * 1.0);
+                prof.Stop(ph_forces);
+
+                ScopedPhase timer(prof, ph_output);
+                if (Mpi::Root())
+                {
+                    cout << "Step " << step << ", t = " << t << ", Cd = " << Cd << ", Cl = " << Cl;
+                    if (adaptive_dt) { cout << ", dt = " << dt << ", CFL = " << cfl; }
+                    cout << endl;
+                }
+                const double record[3] = {t, Cd, Cl};
+                force_file->Append(record);
+            }
+
+            if (pv && step % pv_steps == 0)
             {
-                force_file << t << "\t" << Cd << "\t" << Cl << "\n";
-                force_file.flush();
+                ScopedPhase timer(prof, ph_fields);
+                vorticity->Update(u);
+                pv->SetCycle(step);
+                pv->SetTime(t);
+                pv->Save();
             }
+
+            // Checkpoint the state after this step (step + 1 steps done at t + dt)
+            if (checkpoint_steps > 0 && (step + 1) % checkpoint_steps == 0)
+            {
+                ScopedPhase timer(prof, ph_checkpoint);
+                checkpoint.Save(step + 1, t + dt, dt_hist, bdf_order);
+            }
+
+            prof.EndStep(step, t);
+
+            // Advance time
+            t += dt;
+            step++;
+        }
+
+        // Heap allocations of this case after its warm-up
+        if (step - first_step > alloc_warmup_steps)
+        {
+            loop_allocs += heap_allocations.load() - allocs_at_warmup;
+            alloc_steps += step - first_step - alloc_warmup_steps;
         }
+        total_steps += step - first_step;
 
-        // Advance time
-        t += dt;
-        step++;
+        for (TimeSeriesWriter *file : force_files)
+        {
+            file->Close();
+            delete file;
+        }
+        if (Mpi::Root()) { cout << "Force data saved to: " << force_filename << endl; }
+    }
+
+    double loop_time = MPI_Wtime() - loop_start;
+    MPI_Allreduce(MPI_IN_PLACE, &loop_time, 1, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD);
+
+    // Heap allocations per steady-state step, worst rank
+    MPI_Allreduce(MPI_IN_PLACE, &loop_allocs, 1, MPI_LONG, MPI_MAX, MPI_COMM_WORLD);
+    if (count_allocs && Mpi::Root())
+    {
+        cout << "Heap allocations after warm-up: " << loop_allocs << " in "
+             << alloc_steps << " steps" << endl;
     }
 
-    force_file.close();
+    // Global true-dof norms of the final state: independent of the number of
+    // ranks up to round-off, so runs with different -np can be compared
+    u.GetTrueDofs(ws.U);
+    double u_norm = sqrt(InnerProduct(MPI_COMM_WORLD, ws.U, ws.U));
+    double p_norm = sqrt(InnerProduct(MPI_COMM_WORLD, ws.P, ws.P));
+    if (Mpi::Root())
+    {
+        cout << setprecision(12) << "Final |U| = " << u_norm << ", |P| = " << p_norm
+             << setprecision(6) << endl;
+    }
 
     if (Mpi::Root())
     {
@@ -277,18 +4233,95 @@ int main(int argc, char *argv[])
         auto duration =
             chrono::duration_cast<chrono::milliseconds>(end_time - start_time).count();
         cout << "\nSimulation Complete!" << endl;
-        cout << "Total steps: " << step << endl;
+        cout << "Total steps: " << total_steps << endl;
+        if (adaptive_dt)
+        {
+            cout << "Adaptive dt: " << dt_lo << " to " << dt_hi << ", " << h_refreshes
+                 << " H refreshes, " << vel_amg.NumSetups() << " velocity AMG setups"
+                 << endl;
+        }
         cout << "Total time: " << duration << " ms" << endl;
-        cout << "Force data saved to: forces_simple.dat" << endl;
+    }
+
+    // Per-phase breakdown; AMG V-cycle time is part of the solve phases
+    prof.Report(cout);
+
+    // Operator storage: CSR nonzeros of the assembled matrices (none with -pa)
+    // and the peak RSS, which also covers the PA quadrature data
+    long nnz = LocalNNZ(M) + LocalNNZ(K) + LocalNNZ(S) + LocalNNZ(D) + LocalNNZ(H) +
+               LocalNNZ(G) + (H_elim ? LocalNNZ(&H_elim->Get()) : 0) +
+               (S_elim ? LocalNNZ(&S_elim->Get()) : 0);
+    double rss = PeakRSSMB(), rss_max, rss_sum;
+    MPI_Allreduce(MPI_IN_PLACE, &nnz, 1, MPI_LONG, MPI_SUM, MPI_COMM_WORLD);
+    MPI_Allreduce(&rss, &rss_max, 1, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD);
+    MPI_Allreduce(&rss, &rss_sum, 1, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+    if (Mpi::Root())
+    {
+        cout << "Assembled operator nonzeros: " << nnz << " (~"
+             << nnz * (sizeof(double) + sizeof(HYPRE_Int)) / 1048576.0 << " MB)" << endl;
+        cout << "Peak memory: " << rss_max << " MB max/rank, " << rss_sum << " MB total"
+             << endl;
+    }
+
+    // Machine-readable summary for bench_scaling.py
+    if (*timing_json)
+    {
+        int nranks = Mpi::WorldSize(), ncores = nranks * num_threads;
+        long ne = pmesh->GetGlobalNE();
+        int steps = total_steps;
+        double dofs = (double(vel_size) + pres_size) * batch;
+        ofstream json;
+        if (Mpi::Root())
+        {
+            json.open(timing_json);
+            json << setprecision(8) << "{\n"
+                 << "  \"ranks\": " << nranks << ",\n"
+                 << "  \"threads\": " << num_threads << ",\n"
+                 << "  \"samples\": " << batch << ",\n"
+                 << "  \"order\": " << order << ",\n"
+                 << "  \"elements\": " << ne << ",\n"
+                 << "  \"velocity_dofs\": " << vel_size << ",\n"
+                 << "  \"pressure_dofs\": " << pres_size << ",\n"
+                 << "  \"steps\": " << steps << ",\n"
+                 << "  \"time_loop_s\": " << loop_time << ",\n"
+                 << "  \"dofs_per_s_per_core\": "
+                 << (loop_time > 0.0 ? dofs * steps / loop_time / ncores : 0.0) << ",\n"
+                 << "  \"nonzeros\": " << nnz << ",\n"
+                 << "  \"peak_rss_mb_max\": " << rss_max << ",\n"
+                 << "  \"peak_rss_mb_total\": " << rss_sum << ",\n"
+                 << "  \"phases\": ";
+        }
+        prof.WriteJSON(json);
+        if (Mpi::Root()) { json << "\n}\n"; }
     }
 
     // Cleanup
+    delete pv;
+    delete vorticity;
+    delete vel_pa_prec;
+    delete pres_pa_prec;
+    delete pres_direct;
+    delete mono;
+    delete steady_solver;
+    for (int j = 1; j < (int)samples.size(); j++) { delete samples[j]; }
+    delete vel_bcg;
+    delete pres_bcg;
+    delete Mp;
+    delete h_form;
+    delete H_elim;
+    delete S_elim;
     delete M;
     delete K;
     delete S;
+    delete G;
     delete D;
     delete H;
     delete pmesh;
 
+    if (count_allocs && loop_allocs > 0)
+    {
+        if (Mpi::Root()) cout << "Error: the time loop allocated heap memory" << endl;
+        return 1;
+    }
     return 0;
 }
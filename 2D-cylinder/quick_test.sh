@@ -53,11 +53,14 @@ echo "Simulating 0.5 seconds of flow at Re=100..."
 echo "This may take 10-20 seconds on a typical laptop..."
 echo ""
 
+# Surface-traction forces (-fm 0) on the generated mesh, whose cylinder
+# segments are interior faces
 ./build/navier_simple -m cylinder_structured.mesh \
     -Re 100 \
     -dt 0.01 \
     -t 0.5 \
-    -vs 5
+    -vs 5 \
+    -fm 0
 
 print_success "Simulation complete!"
 
@@ -76,6 +79,63 @@ else
     echo "Warning: No force data found"
 fi
 
+# Step 4: Regression checks, run in their own directory so they do not
+# overwrite the results above
+print_header "Step 4: Regression Checks"
+mkdir -p quick_test_checks
+cd quick_test_checks
+
+echo "Checking that the time loop does not allocate after warm-up (-ca)..."
+../build/navier_simple -m ../cylinder_structured.mesh -Re 100 -dt 0.01 -t 0.1 \
+    -vs 5 -ca > alloc.log || { cat alloc.log; echo "Error: allocation check failed"; exit 1; }
+grep "Heap allocations after warm-up" alloc.log
+print_success "No heap allocations in the steady-state time loop"
+
+# The final true-dof norms must not depend on the number of ranks beyond
+# the solver tolerance (relative difference RANK_TOL)
+echo "Comparing the final state of 1- and 2-rank runs..."
+for np in 1 2; do
+    ${MPIRUN:-mpirun} -np $np ../build/navier_simple -m ../cylinder_structured.mesh \
+        -Re 100 -dt 0.01 -t 0.1 -vs 5 > np$np.log \
+        || { cat np$np.log; echo "Error: run with $np rank(s) failed"; exit 1; }
+done
+python3 - np1.log np2.log "${RANK_TOL:-1e-6}" <<'EOF'
+import re, sys
+norms = []
+for log in sys.argv[1:3]:
+    m = re.search(r"Final \|U\| = (\S+), \|P\| = (\S+)", open(log).read())
+    if not m:
+        sys.exit(f"Error: no final norms in {log}")
+    norms.append((float(m.group(1)), float(m.group(2))))
+tol = float(sys.argv[3])
+for name, a, b in zip(("|U|", "|P|"), *norms):
+    rel = abs(a - b) / max(abs(a), 1e-300)
+    print(f"  {name}: np 1 = {a:.12g}, np 2 = {b:.12g}, relative difference {rel:.2e}")
+    if rel > tol:
+        sys.exit(f"Error: {name} differs between 1 and 2 ranks by more than {tol:g}")
+EOF
+print_success "Final state independent of the rank count"
+
+# Surface-traction drag on the body-fitted O-grid: after the impulsive
+# start Cd must be positive and O(1) (a flipped normal or a moving
+# cylinder gives the wrong sign or ~0)
+echo "Checking the surface-traction drag on the O-grid (-og)..."
+../build/navier_simple -og -ogn 8 -rp 1 -o 2 -Re 100 -dt 0.005 -t 0.3 -vs 5 -fm 0 \
+    > ogrid.log || { cat ogrid.log; echo "Error: O-grid run failed"; exit 1; }
+python3 - forces_simple.dat <<'EOF'
+import sys
+rows = [list(map(float, l.split())) for l in open(sys.argv[1]).readlines()[1:] if l.strip()]
+late = [r for r in rows if r[0] >= 0.5 * rows[-1][0]]
+cd = sum(r[1] for r in late) / len(late)
+cl = max(abs(r[2]) for r in late)
+print(f"  mean Cd = {cd:.4g}, max |Cl| = {cl:.3g} over t >= {late[0][0]:g}")
+if not 0.5 < cd < 20.0 or cl > cd:
+    sys.exit("Error: O-grid drag has the wrong sign or magnitude")
+EOF
+print_success "O-grid drag positive and O(1)"
+
+cd ..
+
 # Summary
 print_header "Test Complete!"
 echo ""
@@ -83,6 +143,8 @@ echo "Summary:"
 echo "  ✓ Mesh: cylinder_structured.mesh (100x100 elements)"
 echo "  ✓ Simulation: 0.5 seconds at Re=100"
 echo "  ✓ Output: forces_simple.png and forces_simple.dat"
+echo "  ✓ Checks: no heap allocations in the time loop, same result on 1 and 2 ranks,"
+echo "            O-grid drag of the right sign and magnitude"
 echo ""
 echo "Next steps:"
 echo "  - View results: forces_simple.png"